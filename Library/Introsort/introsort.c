@@ -5,9 +5,9 @@
 /* ============= Misc ============= */
 
 // Swaps the content of two pointers
-static inline void swap_by_pointers(T* n1, T* n2)
+static inline void swap_by_pointers(item_arg_t* n1, item_arg_t* n2)
 {
-	int temp = *n1;
+	item_arg_t temp = *n1;
 	*n1 = *n2;
 	*n2 = temp;
 }
@@ -29,7 +29,7 @@ static int base10_log(int value)
 *  ========================================================================= */
 
 // Restores the heap properties of an array by moving down the first element
-static void sift_down(T* vector, int start, int end, comparation(*expression)(T, T))
+static void sift_down(item_arg_t* vector, int start, int end, comparation(*expression)(item_arg_t, item_arg_t))
 {
 	// Temp variables
 	int root = start, temp;
@@ -57,7 +57,7 @@ static void sift_down(T* vector, int start, int end, comparation(*expression)(T,
 }
 
 // Trasnforms a vector into a heap structure, in-place
-static void heapify(T* vector, int n, comparation(*expression)(T, T))
+static void heapify(item_arg_t* vector, int n, comparation(*expression)(item_arg_t, item_arg_t))
 {
 	int start = (n - 2) / 2;
 	while (start >= 0)
@@ -68,7 +68,7 @@ static void heapify(T* vector, int n, comparation(*expression)(T, T))
 }
 
 // In-place heapsort algorithm >> O(nlogn) as worst case
-static void heapsort(T* vector, int n, comparation(*expression)(T, T))
+static void heapsort(item_arg_t* vector, int n, comparation(*expression)(item_arg_t, item_arg_t))
 {
 	// Rearrange the target vector as a heap
 	heapify(vector, n, expression);
@@ -93,7 +93,7 @@ static void heapsort(T* vector, int n, comparation(*expression)(T, T))
 *  ========================================================================= */
 
 // Classic in-place insertion sort algorithm >> O(n^2)
-static void insertion_sort(T* vector, const size, comparation(*expression)(T, T))
+static void insertion_sort(item_arg_t* vector, const int size, comparation(*expression)(item_arg_t, item_arg_t))
 {
 	int i, j;
 	for (i = 0; i < size; i++)
@@ -113,11 +113,11 @@ static void insertion_sort(T* vector, const size, comparation(*expression)(T, T)
 *  ========================================================================= */
 
 // Partition function based on the Lomuto's Partitioning Algorithm
-static int partition(T* vector, int left, int right, comparation(*expression)(T, T))
+static int partition(item_arg_t* vector, int left, int right, comparation(*expression)(item_arg_t, item_arg_t))
 {
 	// Pick a random pivot index and select the pivot item
 	int pivot_index = left + (rand() % (right - left + 1));
-	T pivot = vector[pivot_index];
+	item_arg_t pivot = vector[pivot_index];
 
 	swap_by_pointers(vector + pivot_index, vector + right);
 	pivot_index = right;
@@ -143,7 +143,7 @@ static int partition(T* vector, int left, int right, comparation(*expression)(T,
 #define MIN_QUICKSORT_SIZE 9
 
 // Custom introsort algorithm that combines quicksort, heapsort and insertion sort
-static void main_sort(T* vector, int left, int right, comparation(*expression)(T, T), int depth)
+static void main_sort(item_arg_t* vector, int left, int right, comparation(*expression)(item_arg_t, item_arg_t), int depth)
 {
 	// Stop at the base case and calculate the length of the current vector
 	if (left >= right) return;
@@ -169,7 +169,7 @@ static void main_sort(T* vector, int left, int right, comparation(*expression)(T
 }
 
 // Sorts a vector using the custom introsort algorithm
-void introsort(T* vector, int len, comparation(*expression)(T, T))
+void introsort(item_arg_t* vector, int len, comparation(*expression)(item_arg_t, item_arg_t))
 {
 	// Parameters check
 	if (vector == NULL || len <= 0 || expression == NULL) exit(EXIT_FAILURE);
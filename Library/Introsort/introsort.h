@@ -11,9 +11,10 @@
 *    cost of O(nlogn) and it is faster than the heapsort algorithm,
 *    while using less memory than a quicksort algorithm.
 *  Parameters:
-*    vector ---> The vector to sort
+*    vector ---> The vector to sort (with LIST_BY_POINTER, it holds the
+*                pointers to the items, so the items are never moved)
 *    len ---> The number of elements in the vector to sort
 *    expression ---> Comparator lambda expression (see the list_t.h file) */
-void introsort(T* vector, int len, comparation(*expression)(T, T));
+void introsort(item_arg_t* vector, int len, comparation(*expression)(item_arg_t, item_arg_t));
 
 #endif
\ No newline at end of file
@@ -0,0 +1,463 @@
+/* ============================================================================
+*  list_names.h
+* ============================================================================
+
+*  Author:         (c) 2015 Sergio Pedri and Andrea Salvati
+*  License:        See the end of this file for license information
+
+*  NOTE:
+*    This file is included by list_t.h when LIST_NAME is defined: it adds
+*    the LIST_NAME_ prefix to all the public names of the library, so that
+*    lists with different types can be used in the same program. It is
+*    included again with LIST_UNDEF_NAMES defined to remove the prefixes,
+*    once the declarations of a type are complete.
+*/
+
+#ifndef LIST_UNDEF_NAMES
+
+// Builds the name of a symbol for the current LIST_NAME
+#define LIST_CONCAT_NAMES(prefix, name) prefix##_##name
+#define LIST_CONCAT(prefix, name) LIST_CONCAT_NAMES(prefix, name)
+#define LIST_SYMBOL(name) LIST_CONCAT(LIST_NAME, name)
+
+// Types
+#define T LIST_SYMBOL(T)
+#define item_arg_t LIST_SYMBOL(item_arg_t)
+#define list_iterator_t LIST_SYMBOL(list_iterator_t)
+#define list_t LIST_SYMBOL(list_t)
+#define stack_t LIST_SYMBOL(stack_t)
+#define list_stream_t LIST_SYMBOL(list_stream_t)
+#define frozen_list_t LIST_SYMBOL(frozen_list_t)
+#define persistent_list_t LIST_SYMBOL(persistent_list_t)
+#define queue_t LIST_SYMBOL(queue_t)
+#define append_list_t LIST_SYMBOL(append_list_t)
+#define rcu_list_t LIST_SYMBOL(rcu_list_t)
+#define lookup_t LIST_SYMBOL(lookup_t)
+
+// Struct tags
+#define listIterator LIST_SYMBOL(listIterator)
+#define listBase LIST_SYMBOL(listBase)
+#define listStream LIST_SYMBOL(listStream)
+#define frozenList LIST_SYMBOL(frozenList)
+#define persistentList LIST_SYMBOL(persistentList)
+#define ringQueue LIST_SYMBOL(ringQueue)
+#define appendList LIST_SYMBOL(appendList)
+#define rcuList LIST_SYMBOL(rcuList)
+#define lookupTable LIST_SYMBOL(lookupTable)
+
+// Functions
+#define actual_position LIST_SYMBOL(actual_position)
+#define add LIST_SYMBOL(add)
+#define add_all LIST_SYMBOL(add_all)
+#define add_at LIST_SYMBOL(add_at)
+#define add_range LIST_SYMBOL(add_range)
+#define all LIST_SYMBOL(all)
+#define any LIST_SYMBOL(any)
+#define append LIST_SYMBOL(append)
+#define append_range LIST_SYMBOL(append_range)
+#define average LIST_SYMBOL(average)
+#define begin_rcu_read LIST_SYMBOL(begin_rcu_read)
+#define can_go_back LIST_SYMBOL(can_go_back)
+#define can_go_forward LIST_SYMBOL(can_go_forward)
+#define clear LIST_SYMBOL(clear)
+#define close_stream LIST_SYMBOL(close_stream)
+#define concat LIST_SYMBOL(concat)
+#define copy LIST_SYMBOL(copy)
+#define copy_to LIST_SYMBOL(copy_to)
+#define count LIST_SYMBOL(count)
+#define count_distinct LIST_SYMBOL(count_distinct)
+#define create LIST_SYMBOL(create)
+#define create_adopting LIST_SYMBOL(create_adopting)
+#define create_append_list LIST_SYMBOL(create_append_list)
+#define create_array_stack LIST_SYMBOL(create_array_stack)
+#define create_concurrent LIST_SYMBOL(create_concurrent)
+#define enable_hash_index LIST_SYMBOL(enable_hash_index)
+#define disable_hash_index LIST_SYMBOL(disable_hash_index)
+#define enable_bloom_filter LIST_SYMBOL(enable_bloom_filter)
+#define disable_bloom_filter LIST_SYMBOL(disable_bloom_filter)
+#define get_bloom_stats LIST_SYMBOL(get_bloom_stats)
+#define group_by LIST_SYMBOL(group_by)
+#define group_by_parallel LIST_SYMBOL(group_by_parallel)
+#define count_by LIST_SYMBOL(count_by)
+#define sum_by LIST_SYMBOL(sum_by)
+#define min_by LIST_SYMBOL(min_by)
+#define max_by LIST_SYMBOL(max_by)
+#define lookup_size LIST_SYMBOL(lookup_size)
+#define lookup_get LIST_SYMBOL(lookup_get)
+#define lookup_value LIST_SYMBOL(lookup_value)
+#define lookup_keys LIST_SYMBOL(lookup_keys)
+#define destroy_lookup LIST_SYMBOL(destroy_lookup)
+#define create_from LIST_SYMBOL(create_from)
+#define create_from_n LIST_SYMBOL(create_from_n)
+#define create_lock_free_stack LIST_SYMBOL(create_lock_free_stack)
+#define create_persistent LIST_SYMBOL(create_persistent)
+#define create_queue LIST_SYMBOL(create_queue)
+#define create_random LIST_SYMBOL(create_random)
+#define create_rcu_list LIST_SYMBOL(create_rcu_list)
+#define create_spsc_queue LIST_SYMBOL(create_spsc_queue)
+#define dequeue LIST_SYMBOL(dequeue)
+#define dequeue_range LIST_SYMBOL(dequeue_range)
+#define derive LIST_SYMBOL(derive)
+#define derive_in_place LIST_SYMBOL(derive_in_place)
+#define destroy LIST_SYMBOL(destroy)
+#define destroy_append_list LIST_SYMBOL(destroy_append_list)
+#define destroy_frozen LIST_SYMBOL(destroy_frozen)
+#define destroy_iterator LIST_SYMBOL(destroy_iterator)
+#define destroy_persistent LIST_SYMBOL(destroy_persistent)
+#define destroy_queue LIST_SYMBOL(destroy_queue)
+#define destroy_rcu_list LIST_SYMBOL(destroy_rcu_list)
+#define destroy_sequence LIST_SYMBOL(destroy_sequence)
+#define distinct LIST_SYMBOL(distinct)
+#define distinct_in_place LIST_SYMBOL(distinct_in_place)
+#define elements_left LIST_SYMBOL(elements_left)
+#define end_rcu_read LIST_SYMBOL(end_rcu_read)
+#define enqueue LIST_SYMBOL(enqueue)
+#define enqueue_range LIST_SYMBOL(enqueue_range)
+#define except LIST_SYMBOL(except)
+#define first_index_where LIST_SYMBOL(first_index_where)
+#define first_or_default LIST_SYMBOL(first_or_default)
+#define for_each LIST_SYMBOL(for_each)
+#define for_each_remaining LIST_SYMBOL(for_each_remaining)
+#define formatted_print LIST_SYMBOL(formatted_print)
+#define formatted_print_buffer LIST_SYMBOL(formatted_print_buffer)
+#define formatted_print_to LIST_SYMBOL(formatted_print_to)
+#define freeze LIST_SYMBOL(freeze)
+#define frozen_bytes LIST_SYMBOL(frozen_bytes)
+#define frozen_count LIST_SYMBOL(frozen_count)
+#define frozen_for_each LIST_SYMBOL(frozen_for_each)
+#define frozen_is_element LIST_SYMBOL(frozen_is_element)
+#define frozen_size LIST_SYMBOL(frozen_size)
+#define frozen_sum LIST_SYMBOL(frozen_sum)
+#define frozen_to_array LIST_SYMBOL(frozen_to_array)
+#define get LIST_SYMBOL(get)
+#define get_current LIST_SYMBOL(get_current)
+#define get_first LIST_SYMBOL(get_first)
+#define get_iterator LIST_SYMBOL(get_iterator)
+#define get_last LIST_SYMBOL(get_last)
+#define get_max LIST_SYMBOL(get_max)
+#define get_min LIST_SYMBOL(get_min)
+#define get_numeric_max LIST_SYMBOL(get_numeric_max)
+#define get_numeric_min LIST_SYMBOL(get_numeric_min)
+#define in_place_order_by LIST_SYMBOL(in_place_order_by)
+#define in_place_order_by_descending LIST_SYMBOL(in_place_order_by_descending)
+#define index_of LIST_SYMBOL(index_of)
+#define insert_range_at LIST_SYMBOL(insert_range_at)
+#define intersect LIST_SYMBOL(intersect)
+#define introsort LIST_SYMBOL(introsort)
+#define inverse_for_each LIST_SYMBOL(inverse_for_each)
+#define is_element LIST_SYMBOL(is_element)
+#define is_empty LIST_SYMBOL(is_empty)
+#define is_synced LIST_SYMBOL(is_synced)
+#define join LIST_SYMBOL(join)
+#define join_where LIST_SYMBOL(join_where)
+#define last_index_of LIST_SYMBOL(last_index_of)
+#define last_index_where LIST_SYMBOL(last_index_where)
+#define last_or_default LIST_SYMBOL(last_or_default)
+#define load_list LIST_SYMBOL(load_list)
+#define map_list LIST_SYMBOL(map_list)
+#define move_back LIST_SYMBOL(move_back)
+#define move_next LIST_SYMBOL(move_next)
+#define next LIST_SYMBOL(next)
+#define next_chunk LIST_SYMBOL(next_chunk)
+#define open_stream LIST_SYMBOL(open_stream)
+#define open_stream_fd LIST_SYMBOL(open_stream_fd)
+#define order_by LIST_SYMBOL(order_by)
+#define order_by_descending LIST_SYMBOL(order_by_descending)
+#define parse_list LIST_SYMBOL(parse_list)
+#define peek LIST_SYMBOL(peek)
+#define persistent_add LIST_SYMBOL(persistent_add)
+#define persistent_add_at LIST_SYMBOL(persistent_add_at)
+#define persistent_all LIST_SYMBOL(persistent_all)
+#define persistent_any LIST_SYMBOL(persistent_any)
+#define persistent_count LIST_SYMBOL(persistent_count)
+#define persistent_first_or_default LIST_SYMBOL(persistent_first_or_default)
+#define persistent_for_each LIST_SYMBOL(persistent_for_each)
+#define persistent_get LIST_SYMBOL(persistent_get)
+#define persistent_index_of LIST_SYMBOL(persistent_index_of)
+#define persistent_is_element LIST_SYMBOL(persistent_is_element)
+#define persistent_remove_at LIST_SYMBOL(persistent_remove_at)
+#define persistent_replace_at LIST_SYMBOL(persistent_replace_at)
+#define persistent_size LIST_SYMBOL(persistent_size)
+#define persistent_sum LIST_SYMBOL(persistent_sum)
+#define persistent_to_array LIST_SYMBOL(persistent_to_array)
+#define persistent_to_list LIST_SYMBOL(persistent_to_list)
+#define persistent_where LIST_SYMBOL(persistent_where)
+#define pop LIST_SYMBOL(pop)
+#define print LIST_SYMBOL(print)
+#define print_buffer LIST_SYMBOL(print_buffer)
+#define print_to LIST_SYMBOL(print_to)
+#define push LIST_SYMBOL(push)
+#define queue_size LIST_SYMBOL(queue_size)
+#define remove_all_items LIST_SYMBOL(remove_all_items)
+#define remove_at LIST_SYMBOL(remove_at)
+#define remove_item LIST_SYMBOL(remove_item)
+#define remove_where LIST_SYMBOL(remove_where)
+#define remove_where_in_place LIST_SYMBOL(remove_where_in_place)
+#define replace_all_items LIST_SYMBOL(replace_all_items)
+#define replace_at LIST_SYMBOL(replace_at)
+#define replace_item LIST_SYMBOL(replace_item)
+#define replace_where LIST_SYMBOL(replace_where)
+#define replace_where_in_place LIST_SYMBOL(replace_where_in_place)
+#define reserve LIST_SYMBOL(reserve)
+#define restart LIST_SYMBOL(restart)
+#define reverse LIST_SYMBOL(reverse)
+#define reverse_in_place LIST_SYMBOL(reverse_in_place)
+#define reverse_range LIST_SYMBOL(reverse_range)
+#define save_list LIST_SYMBOL(save_list)
+#define seal LIST_SYMBOL(seal)
+#define sequence_equals LIST_SYMBOL(sequence_equals)
+#define single LIST_SYMBOL(single)
+#define size LIST_SYMBOL(size)
+#define skip LIST_SYMBOL(skip)
+#define skip_while LIST_SYMBOL(skip_while)
+#define slice LIST_SYMBOL(slice)
+#define snapshot LIST_SYMBOL(snapshot)
+#define stream_count LIST_SYMBOL(stream_count)
+#define stream_first_or_default LIST_SYMBOL(stream_first_or_default)
+#define stream_for_each LIST_SYMBOL(stream_for_each)
+#define stream_sum LIST_SYMBOL(stream_sum)
+#define sum LIST_SYMBOL(sum)
+#define swap LIST_SYMBOL(swap)
+#define take_range LIST_SYMBOL(take_range)
+#define take_while LIST_SYMBOL(take_while)
+#define thaw LIST_SYMBOL(thaw)
+#define to_array LIST_SYMBOL(to_array)
+#define to_array_borrow LIST_SYMBOL(to_array_borrow)
+#define to_persistent LIST_SYMBOL(to_persistent)
+#define trim LIST_SYMBOL(trim)
+#define try_dequeue LIST_SYMBOL(try_dequeue)
+#define update_rcu_list LIST_SYMBOL(update_rcu_list)
+#define where LIST_SYMBOL(where)
+#define where_in_place LIST_SYMBOL(where_in_place)
+#define zip LIST_SYMBOL(zip)
+
+#else
+
+// Types
+#undef T
+#undef item_arg_t
+#undef list_iterator_t
+#undef list_t
+#undef stack_t
+#undef list_stream_t
+#undef frozen_list_t
+#undef persistent_list_t
+#undef queue_t
+#undef append_list_t
+#undef rcu_list_t
+#undef lookup_t
+
+// Struct tags
+#undef listIterator
+#undef listBase
+#undef listStream
+#undef frozenList
+#undef persistentList
+#undef ringQueue
+#undef appendList
+#undef rcuList
+#undef lookupTable
+
+// Functions
+#undef actual_position
+#undef add
+#undef add_all
+#undef add_at
+#undef add_range
+#undef all
+#undef any
+#undef append
+#undef append_range
+#undef average
+#undef begin_rcu_read
+#undef can_go_back
+#undef can_go_forward
+#undef clear
+#undef close_stream
+#undef concat
+#undef copy
+#undef copy_to
+#undef count
+#undef count_distinct
+#undef create
+#undef create_adopting
+#undef create_append_list
+#undef create_array_stack
+#undef create_concurrent
+#undef enable_hash_index
+#undef disable_hash_index
+#undef enable_bloom_filter
+#undef disable_bloom_filter
+#undef get_bloom_stats
+#undef group_by
+#undef group_by_parallel
+#undef count_by
+#undef sum_by
+#undef min_by
+#undef max_by
+#undef lookup_size
+#undef lookup_get
+#undef lookup_value
+#undef lookup_keys
+#undef destroy_lookup
+#undef create_from
+#undef create_from_n
+#undef create_lock_free_stack
+#undef create_persistent
+#undef create_queue
+#undef create_random
+#undef create_rcu_list
+#undef create_spsc_queue
+#undef dequeue
+#undef dequeue_range
+#undef derive
+#undef derive_in_place
+#undef destroy
+#undef destroy_append_list
+#undef destroy_frozen
+#undef destroy_iterator
+#undef destroy_persistent
+#undef destroy_queue
+#undef destroy_rcu_list
+#undef destroy_sequence
+#undef distinct
+#undef distinct_in_place
+#undef elements_left
+#undef end_rcu_read
+#undef enqueue
+#undef enqueue_range
+#undef except
+#undef first_index_where
+#undef first_or_default
+#undef for_each
+#undef for_each_remaining
+#undef formatted_print
+#undef formatted_print_buffer
+#undef formatted_print_to
+#undef freeze
+#undef frozen_bytes
+#undef frozen_count
+#undef frozen_for_each
+#undef frozen_is_element
+#undef frozen_size
+#undef frozen_sum
+#undef frozen_to_array
+#undef get
+#undef get_current
+#undef get_first
+#undef get_iterator
+#undef get_last
+#undef get_max
+#undef get_min
+#undef get_numeric_max
+#undef get_numeric_min
+#undef in_place_order_by
+#undef in_place_order_by_descending
+#undef index_of
+#undef insert_range_at
+#undef intersect
+#undef introsort
+#undef inverse_for_each
+#undef is_element
+#undef is_empty
+#undef is_synced
+#undef join
+#undef join_where
+#undef last_index_of
+#undef last_index_where
+#undef last_or_default
+#undef load_list
+#undef map_list
+#undef move_back
+#undef move_next
+#undef next
+#undef next_chunk
+#undef open_stream
+#undef open_stream_fd
+#undef order_by
+#undef order_by_descending
+#undef parse_list
+#undef peek
+#undef persistent_add
+#undef persistent_add_at
+#undef persistent_all
+#undef persistent_any
+#undef persistent_count
+#undef persistent_first_or_default
+#undef persistent_for_each
+#undef persistent_get
+#undef persistent_index_of
+#undef persistent_is_element
+#undef persistent_remove_at
+#undef persistent_replace_at
+#undef persistent_size
+#undef persistent_sum
+#undef persistent_to_array
+#undef persistent_to_list
+#undef persistent_where
+#undef pop
+#undef print
+#undef print_buffer
+#undef print_to
+#undef push
+#undef queue_size
+#undef remove_all_items
+#undef remove_at
+#undef remove_item
+#undef remove_where
+#undef remove_where_in_place
+#undef replace_all_items
+#undef replace_at
+#undef replace_item
+#undef replace_where
+#undef replace_where_in_place
+#undef reserve
+#undef restart
+#undef reverse
+#undef reverse_in_place
+#undef reverse_range
+#undef save_list
+#undef seal
+#undef sequence_equals
+#undef single
+#undef size
+#undef skip
+#undef skip_while
+#undef slice
+#undef snapshot
+#undef stream_count
+#undef stream_first_or_default
+#undef stream_for_each
+#undef stream_sum
+#undef sum
+#undef swap
+#undef take_range
+#undef take_while
+#undef thaw
+#undef to_array
+#undef to_array_borrow
+#undef to_persistent
+#undef trim
+#undef try_dequeue
+#undef update_rcu_list
+#undef where
+#undef where_in_place
+#undef zip
+
+#endif
+
+/* Copyright (C) 2015 Sergio Pedri and Andrea Salvati
+
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; If not, see http://www.gnu.org/licenses/
+*/
\ No newline at end of file
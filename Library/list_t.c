@@ -7,8 +7,24 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <limits.h>
 #include <time.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#endif
+#define LIST_T_C
 #include "list_t.h"
 #include "Introsort\introsort.h"
 
@@ -26,6 +42,93 @@ struct listElem
 typedef struct listElem listNode;
 typedef listNode* nodePointer;
 
+/* ---------------------------------------------------------------------
+*  nodeBlock
+*  ---------------------------------------------------------------------
+*  Description:
+*    A contiguous block of list_t nodes. Each list_t allocates its nodes
+*    in blocks and keeps them in a chain, so that bulk functions can
+*    create all their nodes with a single malloc and clear() only has
+*    to release the blocks instead of each single node. */
+struct nodeBlock
+{
+	struct nodeBlock* next;
+	listNode nodes[];
+};
+
+/* ---------------------------------------------------------------------
+*  nodeStore
+*  ---------------------------------------------------------------------
+*  Description:
+*    The memory of a list_t that is shared with its snapshots: its node
+*    blocks and its contiguous storage (with the function to release it)
+*    at the time of a snapshot, and the store of the previous snapshot,
+*    as its nodes are still used. Each list_t that uses the store keeps
+*    a reference to it, and the last one to release it deallocates it. */
+struct nodeStore
+{
+	int references;
+	struct nodeBlock* blocks;
+	T* items;
+	void(*release)(void*);
+	struct nodeStore* previous;
+};
+
+// A slot of a hashIndex: an empty slot has no node and hash INDEX_EMPTY,
+// the slot of a removed node has no node and hash INDEX_TOMBSTONE
+struct indexSlot
+{
+	size_t hash;
+	listNode* node;
+};
+
+/* ---------------------------------------------------------------------
+*  hashIndex
+*  ---------------------------------------------------------------------
+*  Description:
+*    The hash index of a list_t: an open addressing table with the nodes
+*    of the list_t and the hashes of their items. A new node always takes
+*    the first empty slot of its probe sequence and a removed one leaves
+*    a tombstone, until the table is rebuilt: this way the equal items
+*    are found in the same order they have inside the list_t (a node
+*    inserted before some equal ones takes the slot of the first one).
+*    The edits that change all the items or their order rebuild the
+*    table, while the contiguous storage and the nodes copied from the
+*    snapshots set stale and it is rebuilt the next time it is used.
+*    used is the number of slots that are not empty, tombstones included,
+*    and count the number of nodes. */
+struct hashIndex
+{
+	struct indexSlot* slots;
+	int capacity;
+	int count;
+	int used;
+	bool_t stale;
+};
+
+/* ---------------------------------------------------------------------
+*  bloomFilter
+*  ---------------------------------------------------------------------
+*  Description:
+*    The bloom filter of a list_t: each item sets BLOOM_HASHES bits of
+*    one of its 64 bit words, chosen by the hash of the item, so that a
+*    single word tells if an item is surely not inside the list_t.
+*    The new items add their bits, while the removed ones can't clear
+*    theirs: added and removed count them since the last rebuild, and
+*    stale is set by the edits that replace some items. The filter is
+*    rebuilt from the list_t the next time it is used if it is stale,
+*    too full or if most of its items have been removed.
+*    stats are the counters returned by get_bloom_stats. */
+struct bloomFilter
+{
+	uint64_t* words;
+	int wordCount;
+	int added;
+	int removed;
+	bool_t stale;
+	bloom_stats_t stats;
+};
+
 /* ---------------------------------------------------------------------
 *  listBase
 *  ---------------------------------------------------------------------
@@ -34,13 +137,56 @@ typedef listNode* nodePointer;
 *    to the last node (so that functions like get_first(), get_last() and
 *    add() have a O(1) cost), the current length of the list (this way
 *    getting the size has a O(1) cost as well) and a sync variable used
-*    to check if a list iterator is valid for the current list. */
+*    to check if a list iterator is valid for the current list.
+*    It also stores the chain of the allocated node blocks, the total
+*    number of allocated nodes and a chain of the recycled nodes that
+*    can be used again before allocating a new block.
+*    A list_t can also use a contiguous storage instead of its nodes: in
+*    this case items points to the array with its elements and release
+*    is the function used to deallocate it (or NULL if the list_t doesn't
+*    own the array). The first function that edits the structure of the
+*    list_t moves the items inside new nodes and releases the array.
+*    The readonly flag marks the lists whose items can't be edited at all,
+*    like the ones that map a file: every function that would edit them
+*    fails instead.
+*    store is the memory shared with the snapshots of the list_t, and
+*    shared the number of its first nodes that they can see: these nodes
+*    are copied before any edit that doesn't just append new items.
+*    source is the list_t whose nodes are borrowed by a slice, and
+*    sourceSync its sync value when the slice was created: the slice is
+*    only valid while the two values are the same.
+*    lock is the read/write lock of a concurrent list_t, or NULL, and
+*    lockFree the storage of a lock-free stack_t, or NULL.
+*    An array stack_t keeps its items at the end of buffer, an array with
+*    room for reserved items, with the top item in items[0]: push and pop
+*    only move items back and forward, and the read-only functions see
+*    a contiguous storage. buffer is NULL when the array is not owned by
+*    the stack_t (after a snapshot), so that the next push copies it.
+*    index is the optional hash index of the list_t, or NULL, and filter
+*    its optional bloom filter, or NULL. */
 struct listBase
 {
 	nodePointer head;
 	nodePointer tail;
 	int length;
 	unsigned int sync;
+	struct nodeBlock* blocks;
+	nodePointer recycled;
+	int capacity;
+	T* items;
+	void(*release)(void*);
+	bool_t readonly;
+	struct nodeStore* store;
+	int shared;
+	list_t source;
+	unsigned int sourceSync;
+	pthread_rwlock_t* lock;
+	struct lockFreeStack* lockFree;
+	bool_t arrayStack;
+	T* buffer;
+	int reserved;
+	struct hashIndex* index;
+	struct bloomFilter* filter;
 };
 
 /* ---------------------------------------------------------------------
@@ -63,6 +209,263 @@ struct listIterator
 // Type declaration for the list_t iterator
 typedef struct listIterator iteratorInstance;
 
+/* ---------------------------------------------------------------------
+*  listStream
+*  ---------------------------------------------------------------------
+*  Description:
+*    A source of T records read from a file or a file descriptor (fd
+*    is -1 when file is used). It has two buffers: the reader thread
+*    fills one of them while the other one is being used. The count of
+*    each buffer is -1 while it is waiting to be filled, and 0 when the
+*    input is over. current is the buffer being used and position the
+*    index of its next record. failed is set by the reader thread when
+*    a read error ends the input early. */
+struct listStream
+{
+	FILE* file;
+	int fd;
+	T* buffers[2];
+	int counts[2];
+	int capacity;
+	int current;
+	int position;
+	bool_t stopped;
+	bool_t failed;
+	pthread_t reader;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+};
+
+/* ---------------------------------------------------------------------
+*  frozenBlock
+*  ---------------------------------------------------------------------
+*  Description:
+*    The skip index entry of a block of a frozen list: the first item of
+*    the block, its minimum and maximum item and the offset of the
+*    encoded differences between its items. */
+struct frozenBlock
+{
+	long long first;
+	long long min;
+	long long max;
+	size_t offset;
+};
+
+/* ---------------------------------------------------------------------
+*  frozenList
+*  ---------------------------------------------------------------------
+*  Description:
+*    A compressed list: data stores the differences between the items
+*    of each block, as zigzag varints (so that small negative differences
+*    use a single byte too), and sorted is TRUE if the items are in
+*    ascending order, so that the blocks can be searched with a binary
+*    search. */
+struct frozenList
+{
+	int length;
+	int blockCount;
+	struct frozenBlock* blocks;
+	unsigned char* data;
+	size_t dataLength;
+	bool_t sorted;
+};
+
+/* ---------------------------------------------------------------------
+*  persistentNode
+*  ---------------------------------------------------------------------
+*  Description:
+*    A node of the AVL tree used by a persistent list: the items are
+*    sorted by their position, and each node stores the size of its
+*    subtree so that an index can be found in O(log n). A node never
+*    changes after its creation, and it is shared by all the versions
+*    that reference it: references counts them, and the last one to
+*    release it deallocates it. */
+struct persistentNode
+{
+	int references;
+	int height;
+	int size;
+	T info;
+	struct persistentNode* left;
+	struct persistentNode* right;
+};
+
+// Type declaration for a pointer to a persistent tree node
+typedef struct persistentNode* treePointer;
+
+// A version of a persistent list, that owns a reference to its tree
+struct persistentList
+{
+	treePointer root;
+};
+
+// Number of nodes in the first block of a lock-free stack_t, each block doubles it
+#define STACK_BLOCK_NODES 64
+
+// Number of node blocks of a lock-free stack_t, so that all the indexes fit in 31 bits
+#define STACK_POOL_BLOCKS 25
+
+// A node of a lock-free stack_t, that references the next one with its index
+struct stackNode
+{
+	T info;
+	uint32_t next;
+};
+
+// The free nodes kept by a thread for a lock-free stack_t, in a chain
+// that only that thread can use
+struct nodeCache
+{
+	struct lockFreeStack* stack;
+	struct nodeCache* next;
+	uint32_t head;
+	uint32_t tail;
+	int count;
+};
+
+/* ---------------------------------------------------------------------
+*  lockFreeStack
+*  ---------------------------------------------------------------------
+*  Description:
+*    The storage of a lock-free stack_t. Its nodes are taken from a pool
+*    of blocks, each one twice as large as the previous one, that are only
+*    released when the stack_t is destroyed: a node can always be read,
+*    even after another thread popped it. The nodes are referenced by their
+*    index in the pool, starting from 1 (0 is the end of a chain), so that
+*    top can store the index of the first node in its lower 32 bits and a
+*    tag in the upper 32 bits, incremented by each push and pop: a pop
+*    can't succeed if the top node was popped and pushed again after it
+*    was read (the ABA problem).
+*    free is the chain of the nodes released by the threads: a thread only
+*    adds a whole chain to it or takes all of it, so it doesn't need a tag.
+*    allocated is the number of nodes taken from the pool, caches the list
+*    of the node caches of all the threads and cacheKey the key that
+*    stores the cache of the current thread. */
+struct lockFreeStack
+{
+	uint64_t top;
+	uint32_t free;
+	uint32_t allocated;
+	struct stackNode* blocks[STACK_POOL_BLOCKS];
+	struct nodeCache* caches;
+	pthread_key_t cacheKey;
+};
+
+// Size of a cache line, used to keep the positions of a queue_t apart
+#define CACHE_LINE_BYTES 64
+
+// A cell of a queue_t that can be used by many threads, with the position
+// it expects to be used for next
+struct queueCell
+{
+	size_t sequence;
+	T info;
+};
+
+/* ---------------------------------------------------------------------
+*  ringQueue
+*  ---------------------------------------------------------------------
+*  Description:
+*    A queue_t stored in a ring buffer whose length is a power of 2, so
+*    that mask turns a position into an index. enqueuePosition and
+*    dequeuePosition are the positions of the next item to add and to
+*    remove: they only grow, and they are kept on different cache lines
+*    so that producers and consumers don't slow each other down.
+*    A queue_t used by many threads stores its items inside cells: the
+*    sequence of each cell is equal to the position that can enqueue an
+*    item in it, and to that position + 1 once the item can be dequeued
+*    (the algorithm described by Dmitry Vyukov). A queue_t used by a
+*    single producer and a single consumer only stores the items, and
+*    each side keeps the last position of the other side it has seen,
+*    reading the shared one again only when the queue looks full or empty. */
+struct ringQueue
+{
+	size_t mask;
+	bool_t single;
+	struct queueCell* cells;
+	T* items;
+	char producerPadding[CACHE_LINE_BYTES];
+	size_t enqueuePosition;
+	size_t seenDequeuePosition;
+	char consumerPadding[CACHE_LINE_BYTES];
+	size_t dequeuePosition;
+	size_t seenEnqueuePosition;
+	char endPadding[CACHE_LINE_BYTES];
+};
+
+// Number of items in the first chunk of an append_list_t, each chunk doubles it
+#define APPEND_CHUNK_ITEMS 1024
+
+// Number of chunks of an append_list_t, so that they can store INT_MAX items
+#define APPEND_CHUNKS 22
+
+/* ---------------------------------------------------------------------
+*  appendList
+*  ---------------------------------------------------------------------
+*  Description:
+*    An append_list_t: its items are stored in chunks, each one twice as
+*    large as the previous one, allocated by the first thread that needs
+*    them. reserved is the number of positions taken by the threads, with
+*    an atomic addition, and it is kept on its own cache line so that
+*    updating it doesn't slow down the threads reading the chunks.
+*    failed is set when an item couldn't be stored. */
+struct appendList
+{
+	T* chunks[APPEND_CHUNKS];
+	bool_t failed;
+	char padding[CACHE_LINE_BYTES];
+	size_t reserved;
+	char endPadding[CACHE_LINE_BYTES];
+};
+
+/* ---------------------------------------------------------------------
+*  rcuReader
+*  ---------------------------------------------------------------------
+*  Description:
+*    A thread that reads an rcu_list_t: epoch is the epoch of the list
+*    when the thread started reading it, or 0 when it isn't reading it,
+*    and depth the number of nested reads. used is FALSE when the thread
+*    ended, so that another thread can take the rcu_list_t reader.
+*    Each reader is on its own cache line. */
+struct rcuReader
+{
+	size_t epoch;
+	int depth;
+	bool_t used;
+	struct rcuReader* next;
+	char padding[CACHE_LINE_BYTES];
+};
+
+// An old version of an rcu_list_t, replaced during the given epoch
+struct retiredVersion
+{
+	list_t version;
+	size_t epoch;
+	struct retiredVersion* next;
+};
+
+/* ---------------------------------------------------------------------
+*  rcuList
+*  ---------------------------------------------------------------------
+*  Description:
+*    An rcu_list_t: current is the version the readers start from, and
+*    epoch is incremented each time it is replaced, starting from 1.
+*    retired is the chain of the old versions that some readers could
+*    still be using: a version replaced during an epoch is deallocated
+*    when no reader started before the end of that epoch.
+*    readers is the chain of the readers of all the threads, readerKey
+*    the key that stores the reader of the current thread, and writer
+*    the mutex that serializes the updates. */
+struct rcuList
+{
+	list_t current;
+	size_t epoch;
+	struct retiredVersion* retired;
+	struct rcuReader* readers;
+	pthread_key_t readerKey;
+	pthread_mutex_t writer;
+};
+
 /* ============================================================================
 *  Generic functions
 *  ========================================================================= */
@@ -75,1418 +478,5413 @@ list_t create()
 	outList->tail = NULL;
 	outList->length = 0;
 	outList->sync = 0;
+	outList->blocks = NULL;
+	outList->recycled = NULL;
+	outList->capacity = 0;
+	outList->items = NULL;
+	outList->release = NULL;
+	outList->readonly = FALSE;
+	outList->store = NULL;
+	outList->shared = 0;
+	outList->source = NULL;
+	outList->sourceSync = 0;
+	outList->lock = NULL;
+	outList->lockFree = NULL;
+	outList->arrayStack = FALSE;
+	outList->buffer = NULL;
+	outList->reserved = 0;
+	outList->index = NULL;
+	outList->filter = NULL;
 	return outList;
 }
 
-#define GET_ITERATOR(target) nodePointer iterator = target
-#define GET_HEAD_ITERATOR GET_ITERATOR(list->head)
-#define GET_TAIL_ITERATOR GET_ITERATOR(list->tail)
-#define MOVE_NEXT iterator = iterator->next
-#define MOVE_NEXT_W_INDEX(index) MOVE_NEXT; index++
-#define MOVE_BACK iterator = iterator->previous
-#define MOVE_BACK_W_INDEX(index) MOVE_BACK; index--
-#define SYNC_PLUS list->sync++;
-
-#define CLEAR_LIST   \
-list->length = 0;    \
-list->head = NULL;   \
-list->tail = NULL
-
-// Clear
-bool_t clear(list_t list)
+// CreateConcurrent
+list_t create_concurrent()
 {
-	if (list == NULL) return FALSE;
-	if (list->length == 0) return TRUE;
-	SYNC_PLUS;
-	if (list->length == 1)
-	{
-		free(list->head);
-		CLEAR_LIST;
-		return TRUE;
-	}
-	GET_ITERATOR(list->head->next);
-	while (TRUE)
+	list_t outList = create();
+	outList->lock = (pthread_rwlock_t*)malloc(sizeof(pthread_rwlock_t));
+	if (outList->lock == NULL || pthread_rwlock_init(outList->lock, NULL) != 0)
 	{
-		free(iterator->previous);
-		if (iterator->next == NULL)
-		{
-			free(iterator);
-			break;
-		}
-		MOVE_NEXT;
+		free(outList->lock);
+		free(outList);
+		return NULL;
 	}
-	CLEAR_LIST;
-	return TRUE;
+	return outList;
 }
 
-// Destroy
-bool_t destroy(list_t* list)
+/* ================== Locking ================== */
+
+// Maximum number of concurrent lists a thread can lock at the same time
+#define MAX_HELD_LISTS 16
+
+// A concurrent list_t locked by the current thread, and the mode of its lock
+struct heldLock
 {
-	if (clear(*list))
-	{
-		free(*list);
-		*list = NULL;
-		return TRUE;
-	}
-	return FALSE;
-}
+	list_t list;
+	bool_t exclusive;
+};
 
-#define ASSIGN_IF_NOT_NULL(value)    \
-if (result != NULL) *result = value
+// The concurrent lists locked by the current thread, in locking order: a
+// function called while one of them is locked (by another function or
+// from inside an expression) doesn't lock it again
+static __thread struct heldLock heldLists[MAX_HELD_LISTS];
+static __thread int heldCount = 0;
 
-// DestroySequence
-void destroy_sequence(bool_t* result, list_t** pending)
+// Returned by lockList when a function that edits a list_t is called while
+// the current thread only holds a shared lock on it (from inside the
+// expression of a function that reads it): the other readers could be
+// using the list_t, so the edit fails instead
+#define LOCK_DENIED ((list_t)(uintptr_t)-1)
+
+// Checks if a slice was created before the last change of its source list_t
+#define STALE_SLICE(list) ((list)->source != NULL && (list)->source->sync != (list)->sourceSync)
+
+// Empties a slice whose source list_t has changed, so that it never reads
+// the old nodes or items of its source (which could have been released).
+// The iterators of the slice go out of sync too. Only called on a slice,
+// after the list_t has been locked
+static inline void expireSlice(list_t list)
 {
-	if (pending == NULL)
+	if (list->length == 0 || !STALE_SLICE(list)) return;
+	list->head = NULL;
+	list->tail = NULL;
+	list->items = NULL;
+	list->length = 0;
+	list->sync++;
+}
+
+// Locks a concurrent list_t, unless the current thread is already using it.
+// Returns the list_t to unlock later, NULL if it wasn't locked here, or
+// LOCK_DENIED if an exclusive lock is requested under a shared one.
+// Every function that uses a list_t starts here, so it also expires a stale
+// slice. source never changes after slice, so the other lists don't read
+// any of their fields before the lock is taken
+static inline list_t lockList(list_t list, bool_t exclusive)
+{
+	if (list == NULL) return NULL;
+	if (list->lock == NULL)
 	{
-		ASSIGN_IF_NOT_NULL(FALSE);
-		return;
+		if (list->source != NULL) expireSlice(list);
+		return NULL;
 	}
-	if (*pending == NULL)
+	int i;
+	for (i = 0; i < heldCount; i++)
 	{
-		ASSIGN_IF_NOT_NULL(FALSE);
-		return;
+		if (heldLists[i].list == list) return exclusive && !heldLists[i].exclusive ? LOCK_DENIED : NULL;
 	}
-	bool_t destroyed = FALSE;
-	while (*pending)
+	if (exclusive) pthread_rwlock_wrlock(list->lock);
+	else pthread_rwlock_rdlock(list->lock);
+	if (heldCount < MAX_HELD_LISTS)
 	{
-		destroy(*pending);
-		destroyed = TRUE;
-		pending++;
+		heldLists[heldCount].list = list;
+		heldLists[heldCount++].exclusive = exclusive;
 	}
-	ASSIGN_IF_NOT_NULL(destroyed);
+	if (list->source != NULL) expireSlice(list);
+	return list;
 }
 
-// Copy
-list_t copy(const list_t source)
+// Unlocks a list_t locked by lockList, when the variable that holds it goes out of scope
+static inline void unlockList(list_t* held)
 {
-	if (source == NULL) return NULL;
-	list_t outList = create();
-	if (source->length == 0) return outList;
-	GET_ITERATOR(source->head);
-	while (iterator != NULL)
-	{
-		add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	return outList;
+	if (*held == NULL || *held == LOCK_DENIED) return;
+	if (heldCount > 0 && heldLists[heldCount - 1].list == *held) heldCount--;
+	pthread_rwlock_unlock((*held)->lock);
 }
 
-// Create random
-list_t create_random(int length, int min, int max)
+// Locks two lists in address order, so that two threads locking the same
+// lists in a different order can't wait for each other
+static inline list_t lockLower(list_t list1, bool_t exclusive1, list_t list2, bool_t exclusive2)
 {
-	if (min >= max) return NULL;
-	if (length == 0) return create();
-	list_t outList = create();
-	srand((unsigned)time(NULL));
-	while (length != 0)
-	{
-		add((T)((rand() % (max - min)) + min), outList);
-		length--;
-	}
-	return outList;
+	if (list1 == list2) return lockList(list1, exclusive1 || exclusive2);
+	return (uintptr_t)list1 < (uintptr_t)list2 ? lockList(list1, exclusive1) : lockList(list2, exclusive2);
 }
 
-// CreateFrom
-list_t create_from(T* array, int size)
+static inline list_t lockHigher(list_t list1, bool_t exclusive1, list_t list2, bool_t exclusive2)
 {
-	if (array == NULL || size <= 0) return NULL;
-	list_t outList = create();
-	int i;
-	for (i = 0; i < size; i++)
-	{
-		add(array[i], outList);
-	}
-	return outList;
+	if (list1 == list2) return NULL;
+	return (uintptr_t)list1 < (uintptr_t)list2 ? lockList(list2, exclusive2) : lockList(list1, exclusive1);
 }
 
-// ToArray
-T* to_array(list_t list, int* size)
-{
-	if (list == NULL || list->length == 0)
-	{
-		*size = -1;
-		return NULL;
-	}
-	*size = list->length;
-	T* array = (T*)malloc(sizeof(T) * (*size));
-	int i = 0;
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
-	{
-		array[i] = iterator->info;
-		i++;
-		MOVE_NEXT;
-	}
-	return array;
-}
+// Locks a concurrent list_t until the end of the current function, shared
+// for the functions that only read it and exclusive for the ones that edit
+// it, which return the given value if the lock is denied
+#define LOCK_LIST(list, exclusive) \
+list_t heldList __attribute__((cleanup(unlockList))) = lockList(list, exclusive)
+#define READ_LOCK(list) LOCK_LIST(list, FALSE)
+#define WRITE_LOCK(list, value) LOCK_LIST(list, TRUE); if (heldList == LOCK_DENIED) return value
+#define READ_LOCK_ITERATOR READ_LOCK(iterator == NULL ? NULL : iterator->list)
 
-#define CHECK_EMPTY(list) list == NULL || list->length == 0
-#define NULL_IF_EMPTY(list) if (CHECK_EMPTY(list)) return NULL
-#define RETURN_IF_EMPTY(list, value) if (CHECK_EMPTY(list)) return value
+// Locks two lists until the end of the current function
+#define LOCK_PAIR(list1, exclusive1, list2, exclusive2)                                             \
+list_t heldLower __attribute__((cleanup(unlockList))) = lockLower(list1, exclusive1, list2, exclusive2);  \
+list_t heldHigher __attribute__((cleanup(unlockList))) = lockHigher(list1, exclusive1, list2, exclusive2)
+#define READ_LOCK_PAIR LOCK_PAIR(list1, FALSE, list2, FALSE)
 
-// IsEmpty
-bool_t is_empty(list_t list)
+/* ================== Node allocation ================== */
+
+// Minimum and maximum number of nodes allocated by a single add() call
+#define MIN_BLOCK_SIZE 8
+#define MAX_BLOCK_SIZE 65536
+
+// Allocates a new block with the given number of nodes, without linking them
+static nodePointer allocateBlock(list_t list, int count)
 {
-	return CHECK_EMPTY(list);
+	struct nodeBlock* block = (struct nodeBlock*)malloc(sizeof(struct nodeBlock) + sizeof(listNode) * count);
+	block->next = list->blocks;
+	list->blocks = block;
+	list->capacity += count;
+	return block->nodes;
 }
 
-// IsElement
-bool_t is_element(const T item, list_t list)
+// Returns a free node, allocating a new block if there aren't recycled ones left
+static inline nodePointer allocateNode(list_t list)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	if (list->recycled == NULL)
 	{
-		if (iterator->info == item) return TRUE;
-		MOVE_NEXT;
+		// Grow geometrically, so that the number of blocks stays logarithmic
+		int count = list->capacity;
+		if (count < MIN_BLOCK_SIZE) count = MIN_BLOCK_SIZE;
+		else if (count > MAX_BLOCK_SIZE) count = MAX_BLOCK_SIZE;
+		nodePointer nodes = allocateBlock(list, count);
+		int i;
+		for (i = 0; i < count - 1; i++) nodes[i].next = nodes + i + 1;
+		nodes[count - 1].next = NULL;
+		list->recycled = nodes;
 	}
-	return FALSE;
+	nodePointer node = list->recycled;
+	list->recycled = node->next;
+	return node;
 }
 
-// Inline function used inside the get_first and peek functions
-static inline bool_t GetFirst(list_t list, T* result)
+static void indexNodes(list_t list, nodePointer first, int count);
+static void unindexNode(list_t list, nodePointer node);
+static void filterNodes(list_t list, nodePointer first, int count);
+
+// Gives a node that has been unlinked from the list_t back to its pool
+static inline void releaseNode(list_t list, nodePointer node)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	*result = list->head->info;
-	return TRUE;
+	unindexNode(list, node);
+	node->next = list->recycled;
+	list->recycled = node;
+	if (list->filter != NULL) list->filter->removed++;
 }
 
-// GetFirst
-bool_t get_first(list_t list, T* result)
+// Unlinks a node from its list_t and recycles it, without touching sync
+static inline void unlinkNode(list_t list, nodePointer node)
 {
-	return GetFirst(list, result);
+	if (node->previous == NULL) list->head = node->next;
+	else node->previous->next = node->next;
+	if (node->next == NULL) list->tail = node->previous;
+	else node->next->previous = node->previous;
+	releaseNode(list, node);
+	list->length--;
 }
 
-// GetLast
-bool_t get_last(list_t list, T* result)
-{
-	RETURN_IF_EMPTY(list, FALSE);
-	*result = list->tail->info;
-	return TRUE;
+// Allocates a block of count nodes and links them to each other, using
+// value (an expression that can use the index i) to initialize each node
+#define FILL_BLOCK(nodes, count, value)                     \
+nodePointer nodes = allocateBlock(list, count);             \
+{                                                           \
+	int i;                                                  \
+	for (i = 0; i < count; i++)                             \
+	{                                                       \
+		nodes[i].previous = i == 0 ? NULL : nodes + i - 1;  \
+		nodes[i].info = value;                              \
+		nodes[i].next = nodes + i + 1;                      \
+	}                                                       \
+	nodes[count - 1].next = NULL;                           \
 }
 
-// Get
-bool_t get(list_t list, int index, T* result)
+// Makes the hash index of a list_t stale, if it has one
+#define STALE_INDEX(list) if ((list)->index != NULL) (list)->index->stale = TRUE
+
+// Links a chain of count nodes after the given node (or as the new head if NULL)
+static void spliceNodes(list_t list, nodePointer first, nodePointer last, int count, nodePointer after)
 {
-	if (index < 0 || index >= list->length) return FALSE;
-	bool_t fromHead = index <= list->length / 2;
-	if (fromHead)
-	{
-		int position = 0;
-		GET_HEAD_ITERATOR;;
-		while (iterator != NULL)
-		{
-			if (position == index)
-			{
-				*result = iterator->info;
-				return TRUE;
-			}
-			MOVE_NEXT_W_INDEX(position);
-		}
-	}
-	else
-	{
-		int position = list->length - 1;
-		GET_TAIL_ITERATOR;
-		while (iterator != NULL)
-		{
-			if (position == index)
-			{
-				*result = iterator->info;
-				return TRUE;
-			}
-			MOVE_BACK_W_INDEX(position);
-		}
-	}
-	return FALSE;
+	nodePointer before = after == NULL ? list->head : after->next;
+	first->previous = after;
+	last->next = before;
+	if (after == NULL) list->head = first;
+	else after->next = first;
+	if (before == NULL) list->tail = last;
+	else before->previous = last;
+	list->length += count;
+	indexNodes(list, first, count);
+	filterNodes(list, first, count);
 }
 
-// IndexOf
-int index_of(const T item, list_t list)
+#define GET_ITERATOR(target) nodePointer iterator = target
+#define GET_HEAD_ITERATOR GET_ITERATOR(list->head)
+#define GET_TAIL_ITERATOR GET_ITERATOR(list->tail)
+#define MOVE_NEXT iterator = iterator->next
+#define MOVE_NEXT_W_INDEX(index) MOVE_NEXT; index++
+#define MOVE_BACK iterator = iterator->previous
+#define MOVE_BACK_W_INDEX(index) MOVE_BACK; index--
+#define SYNC_PLUS list->sync++;
+
+// Checks if two items are equal, using LIST_EQUALS when the list type has one
+#ifdef LIST_EQUALS
+#define ITEMS_EQUAL(item1, item2) LIST_EQUALS(item1, item2)
+#else
+#define ITEMS_EQUAL(item1, item2) ((item1) == (item2))
+#endif
+
+// Declares the item of a loop. With LIST_BY_POINTER, it only declares the
+// item##Ref pointer to the stored item, so that the item is never copied:
+// SCANNED_ARG passes it to a callback and SCANNED_ITEM reads the item
+// through it, and the loop bodies always use them instead of the item.
+// ITEM_ARG passes any other item stored in memory to a callback
+#ifdef LIST_BY_POINTER
+#define SCAN_ITEM(item, source) \
+const T* item##Ref = &(source); \
+(void)item##Ref
+#define SCANNED_ARG(item) item##Ref
+#define SCANNED_ITEM(item) (*item##Ref)
+#define ITEM_ARG(value) (&(value))
+#else
+#define SCAN_ITEM(item, source) T item = (source)
+#define SCANNED_ARG(item) item
+#define SCANNED_ITEM(item) item
+#define ITEM_ARG(value) (value)
+#endif
+
+#define CLEAR_LIST   \
+list->length = 0;    \
+list->head = NULL;   \
+list->tail = NULL
+
+// Loops over all the items inside a list_t, from the first one to the last
+// one, assigning each of them to item whatever the storage of the list_t is.
+// The loop body can use break, continue and return like in a standard loop
+#define SCAN_FORWARD(list, item, ...)                             \
+if ((list)->items != NULL)                                        \
+{                                                                 \
+	const T* scanPointer = (list)->items;                         \
+	const T* scanEnd = scanPointer + (list)->length;              \
+	for (; scanPointer != scanEnd; scanPointer++)                 \
+	{                                                             \
+		SCAN_ITEM(item, *scanPointer);                            \
+		__VA_ARGS__                                               \
+	}                                                             \
+}                                                                 \
+else                                                              \
+{                                                                 \
+	nodePointer scanNode = (list)->head;                          \
+	int scanLeft = (list)->length;                                \
+	for (; scanLeft > 0; scanLeft--)                              \
+	{                                                             \
+		SCAN_ITEM(item, scanNode->info);                          \
+		if (scanLeft != 1) scanNode = scanNode->next;             \
+		__VA_ARGS__                                               \
+	}                                                             \
+}
+
+// Same as SCAN_FORWARD, but it starts from the last item and moves backwards
+#define SCAN_BACKWARD(list, item, ...)                                \
+if ((list)->items != NULL)                                            \
+{                                                                     \
+	const T* scanPointer = (list)->items + (list)->length;            \
+	const T* scanEnd = (list)->items;                                 \
+	while (scanPointer != scanEnd)                                    \
+	{                                                                 \
+		SCAN_ITEM(item, *--scanPointer);                              \
+		__VA_ARGS__                                                   \
+	}                                                                 \
+}                                                                     \
+else                                                                  \
+{                                                                     \
+	nodePointer scanNode = (list)->tail;                              \
+	int scanLeft = (list)->length;                                    \
+	for (; scanLeft > 0; scanLeft--)                                  \
+	{                                                                 \
+		SCAN_ITEM(item, scanNode->info);                              \
+		if (scanLeft != 1) scanNode = scanNode->previous;             \
+		__VA_ARGS__                                                   \
+	}                                                                 \
+}
+
+// Gets the first and the last item of a list_t that is not empty
+#define FIRST_ITEM(list) ((list)->items != NULL ? (list)->items[0] : (list)->head->info)
+#define LAST_ITEM(list) ((list)->items != NULL ? (list)->items[(list)->length - 1] : (list)->tail->info)
+
+// Releases the contiguous storage of a list_t, if present
+static inline void releaseItems(list_t list)
 {
-	RETURN_IF_EMPTY(list, -1);
-	int index = 0;
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
-	{
-		if (iterator->info == item) return index;
-		MOVE_NEXT_W_INDEX(index);
-	}
-	return -1;
+	free(list->buffer);
+	list->buffer = NULL;
+	list->reserved = 0;
+	if (list->items == NULL) return;
+	if (list->release != NULL) list->release(list->items);
+	list->items = NULL;
+	list->release = NULL;
 }
 
-// LastIndexOf
-int last_index_of(const T item, list_t list)
+// Releases the reference of a list_t to its shared store
+static void releaseStore(list_t list)
 {
-	RETURN_IF_EMPTY(list, -1);
-	int index = list->length - 1;
-	GET_TAIL_ITERATOR;
-	while (iterator != NULL)
+	struct nodeStore* store = list->store;
+	list->store = NULL;
+	list->shared = 0;
+	while (store != NULL && __atomic_sub_fetch(&store->references, 1, __ATOMIC_ACQ_REL) == 0)
 	{
-		if (iterator->info == item) return index;
-		MOVE_BACK_W_INDEX(index);
+		struct nodeStore* previous = store->previous;
+		while (store->blocks != NULL)
+		{
+			struct nodeBlock* temp = store->blocks;
+			store->blocks = temp->next;
+			free(temp);
+		}
+		if (store->release != NULL) store->release(store->items);
+		free(store);
+		store = previous;
 	}
-	return -1;
 }
 
-// Add
-bool_t add(const T item, list_t list)
+// Copies the nodes of a list_t that are shared with its snapshots, so that
+// they can be edited. The nodes appended after the last snapshot are kept
+static void unshareNodes(list_t list)
 {
-	if (list == NULL) return FALSE;
-	nodePointer newNode = (nodePointer)malloc(sizeof(listNode));
-	newNode->info = item;
-	newNode->next = NULL;
-	if (list->length == 0)
-	{		
-		newNode->previous = NULL;
-		list->head = newNode;
-		list->tail = newNode;
-	}
-	else
+	int count = list->shared;
+	list->shared = 0;
+
+	// Nothing to do if the snapshots have already been destroyed
+	if (count == 0 || __atomic_load_n(&list->store->references, __ATOMIC_ACQUIRE) == 1) return;
+	nodePointer nodes = allocateBlock(list, count), source = list->head;
+	int i;
+	for (i = 0; i < count; i++)
 	{
-		newNode->previous = list->tail;
-		list->tail->next = newNode;
-		list->tail = newNode;
+		nodes[i].previous = i == 0 ? NULL : nodes + i - 1;
+		nodes[i].info = source->info;
+		nodes[i].next = nodes + i + 1;
+		if (i != count - 1) source = source->next;
 	}
-	list->length++;
-	SYNC_PLUS;
-	return TRUE;
+
+	// Link the copies to the nodes that were appended later
+	nodePointer rest = count == list->length ? NULL : source->next;
+	nodes[count - 1].next = rest;
+	if (rest == NULL) list->tail = nodes + count - 1;
+	else rest->previous = nodes + count - 1;
+	list->head = nodes;
+	releaseStore(list);
+	STALE_INDEX(list);
 }
 
-// AddAt
-bool_t add_at(const T item, list_t list, int index)
+// Moves the items of a list_t that uses a contiguous storage inside new
+// nodes, so that its structure can be edited like any other list_t.
+// The existing iterators become invalid, as they can't follow the items.
+// Returns FALSE if the list_t is a read-only view that can't be edited
+static bool_t ensureNodes(list_t list)
 {
-	if (CHECK_EMPTY(list) || index < 0 || index >= list->length) return FALSE;
-	if (index == 0) return add(item, list);
-	bool_t fromHead = index <= list->length / 2;
-	nodePointer newNode = (nodePointer)malloc(sizeof(listNode));
-	newNode->info = item;
-	if (fromHead)
-	{
-		int position = 0;
-		GET_HEAD_ITERATOR;
-		while (iterator != NULL)
-		{
-			if (position == index)
-			{
-				newNode->previous = iterator->previous;
-				newNode->previous->next = newNode;
-				newNode->next = iterator;
-				iterator->previous = newNode;
-				break;
-			}
-			MOVE_NEXT_W_INDEX(position);
-		}
-	}
-	else
+	if (list->readonly) return FALSE;
+	if (list->items == NULL) return TRUE;
+	SYNC_PLUS;
+	int length = list->length;
+	if (length > 0)
 	{
-		int position = list->length - 1;
-		GET_TAIL_ITERATOR;
-		while (iterator != NULL)
-		{
-			if (position == index)
-			{
-				newNode->previous = iterator->previous;
-				newNode->previous->next = newNode;
-				newNode->next = iterator;
-				iterator->previous = newNode;
-				break;
-			}
-			MOVE_BACK_W_INDEX(position);
-		}
+		T* items = list->items;
+		FILL_BLOCK(nodes, length, items[i]);
+		list->length = 0;
+		spliceNodes(list, nodes, nodes + length - 1, length, NULL);
 	}
-	SYNC_PLUS;
-	list->length++;
+	releaseItems(list);
+
+	// The snapshots can keep the storage, the new nodes are not shared
+	releaseStore(list);
+	STALE_INDEX(list);
 	return TRUE;
 }
 
-// AddAll
-bool_t add_all(list_t target, const list_t source)
+// Makes sure a list_t can be edited and, unless the edit only appends new
+// items, copies the nodes shared with its snapshots before they change
+static inline bool_t prepareEdit(list_t list, bool_t append)
 {
-	if (target == NULL) return FALSE;
-	RETURN_IF_EMPTY(source, FALSE);
-	GET_ITERATOR(source->head);
-	while (iterator != NULL)
-	{
-		add(iterator->info, target);
-		MOVE_NEXT;
-	}
+	if (!ensureNodes(list)) return FALSE;
+	if (!append && list->shared > 0) unshareNodes(list);
 	return TRUE;
 }
 
-#define SIZE(list) list == NULL ? -1 : list->length
+// Makes sure a list_t can be edited (or appended to), or returns the given value
+#define ENSURE_NODES(list, value) if (!prepareEdit(list, FALSE)) return value
+#define ENSURE_APPEND(list, value) if (!prepareEdit(list, TRUE)) return value
 
-// Size
-int size(list_t list)
+// Makes the bloom filter of a list_t stale, if it has one
+#define STALE_FILTER(list) if ((list)->filter != NULL) (list)->filter->stale = TRUE
+
+// Makes sure the items of a list_t can be replaced, or returns the given value.
+// The bloom filter can't clear the bits of the replaced items, so it becomes stale
+#define ENSURE_REPLACE(list, value) ENSURE_NODES(list, value); STALE_FILTER(list)
+
+/* ================== Hash index ================== */
+
+#define INDEX_EMPTY 0
+#define INDEX_TOMBSTONE 1
+
+// Returns the hash of an item: LIST_HASH when the list type has one, or
+// a hash of its bytes. A list type with LIST_EQUALS but without LIST_HASH
+// can't know which bytes make two items equal, so all its items have the
+// same hash (and enable_hash_index fails)
+#ifdef LIST_HASH
+static inline size_t hashItem(const T item)
 {
-	return SIZE(list);
+	return (size_t)(LIST_HASH(item));
+}
+#elif defined(LIST_EQUALS)
+static inline size_t hashItem(const T item)
+{
+	(void)item;
+	return 0;
 }
+#else
+static inline size_t hashItem(const T item)
+{
+	// Adding 0 turns -0.0 into 0.0, as the equal items need the same bytes
+	T value;
+	memset(&value, 0, sizeof(T));
+	value = (T)(item + 0);
+	const unsigned char* bytes = (const unsigned char*)&value;
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i;
+	for (i = 0; i < sizeof(T); i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	return (size_t)(hash ^ (hash >> 32));
+}
+#endif
 
-// RemoveItem
-bool_t remove_item(const T item, list_t list)
+// Places a node inside the first empty slot of its probe sequence
+static inline void placeNode(struct hashIndex* index, nodePointer node)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	if (list->length == 1)
+	size_t hash = hashItem(node->info), mask = index->capacity - 1, i = hash & mask;
+	while (index->slots[i].node != NULL || index->slots[i].hash != INDEX_EMPTY) i = (i + 1) & mask;
+	index->slots[i].hash = hash;
+	index->slots[i].node = node;
+	index->count++;
+	index->used++;
+}
+
+// Rebuilds the hash index of a list_t from its nodes, with at least twice
+// as many slots as its items. Returns FALSE if there isn't enough memory,
+// in this case the index stays stale
+static bool_t rebuildIndex(list_t list)
+{
+	struct hashIndex* index = list->index;
+	int capacity = 16;
+	while (capacity < list->length * 2 + 2) capacity <<= 1;
+	struct indexSlot* slots = (struct indexSlot*)calloc(capacity, sizeof(struct indexSlot));
+	if (slots == NULL)
 	{
-		if (list->head->info == item)
-		{
-			free(list->head);
-			list->head = NULL;
-			list->tail = NULL;
-			list->length = 0;
-			SYNC_PLUS;
-			return TRUE;
-		}
-		else return FALSE;
+		index->stale = TRUE;
+		return FALSE;
 	}
+	free(index->slots);
+	index->slots = slots;
+	index->capacity = capacity;
+	index->count = 0;
+	index->used = 0;
+	index->stale = FALSE;
 	GET_HEAD_ITERATOR;
 	while (iterator != NULL)
 	{
-		if (iterator->info == item)
-		{
-			// First node inside the list_t
-			if (iterator->previous == NULL)
-			{
-				iterator->next->previous = NULL;
-				list->head = iterator->next;
-			}
-			else if (iterator->next == NULL)
-			{
-				//Last node of the list_t
-				iterator->previous->next = NULL;
-				list->tail = iterator->previous;
-			}
-			else 
-			{
-				// Random position inside the list_t
-				iterator->previous->next = iterator->next;
-				iterator->next->previous = iterator->previous;
-			}			
-			free(iterator);
-			list->length--;
-			SYNC_PLUS;
-			return TRUE;
-		}
+		placeNode(index, iterator);
 		MOVE_NEXT;
 	}
-	return FALSE;
+	return TRUE;
 }
 
-// RemoveAt
-bool_t remove_at(list_t list, int index)
+// Returns the next slot with a node equal to the given item, after the
+// given slot (or from the start of the probe sequence if it is -1),
+// or -1 if there aren't other equal nodes
+static int findSlot(struct hashIndex* index, const T item, size_t hash, int after)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	if (index < 0 || index >= list->length) return FALSE;
-	if (index == 0 && list->length == 1)
+	size_t mask = index->capacity - 1;
+	size_t i = after < 0 ? hash & mask : ((size_t)after + 1) & mask;
+	while (TRUE)
 	{
-		free(list->head);
-		list->head = NULL;
-		list->tail = NULL;
-		list->length = 0;
-		SYNC_PLUS;
-		return TRUE;
+		struct indexSlot* slot = index->slots + i;
+		if (slot->node == NULL)
+		{
+			if (slot->hash == INDEX_EMPTY) return -1;
+		}
+		else if (slot->hash == hash && ITEMS_EQUAL(slot->node->info, item)) return (int)i;
+		i = (i + 1) & mask;
 	}
-	else if (index == 0 && list->length > 1)
+}
+
+// Places a node that isn't the last of its list_t, then moves it before
+// the first equal node that follows it, so that the equal items are still
+// found in order: each equal node from there on takes the slot of the
+// next one, and the last of them takes the slot of the new node
+static void placeInsideNode(struct hashIndex* index, nodePointer node)
+{
+	placeNode(index, node);
+	T item = node->info;
+	size_t hash = hashItem(item);
+	int slot = findSlot(index, item, hash, -1);
+	if (index->slots[slot].node == node) return;
+	nodePointer next = node->next;
+	while (next != NULL && !ITEMS_EQUAL(next->info, item)) next = next->next;
+	if (next == NULL) return;
+	while (index->slots[slot].node != next) slot = findSlot(index, item, hash, slot);
+	nodePointer moved = node;
+	while (slot >= 0)
 	{
-		nodePointer temp = list->head;
-		list->head = temp->next;
-		list->head->previous = NULL;
-		free(temp);
-		list->length--;
-		SYNC_PLUS;
-		return TRUE;
+		nodePointer temp = index->slots[slot].node;
+		index->slots[slot].node = moved;
+		moved = temp;
+		slot = findSlot(index, item, hash, slot);
 	}
-	else if (index == list->length - 1)
+}
+
+// Adds a chain of count nodes just linked to a list_t to its hash index, if
+// it has an updated one, rebuilding the table when it is three quarters full.
+// The nodes inserted before the end are placed from the last one, so that
+// the equal nodes that follow each of them are already in the table
+static void indexNodes(list_t list, nodePointer first, int count)
+{
+	struct hashIndex* index = list->index;
+	if (index == NULL || index->stale) return;
+	if ((long long)(index->used + count) * 4 > (long long)index->capacity * 3)
 	{
-		nodePointer temp = list->tail;
-		list->tail = list->tail->previous;
-		list->tail->next = NULL;
-		free(temp);
-		list->length--;
-		SYNC_PLUS;
-		return TRUE;
+		rebuildIndex(list);
+		return;
 	}
-	bool_t fromHead = index <= list->length / 2;
-	if (fromHead)
+	nodePointer last = first;
+	int i;
+	for (i = 1; i < count; i++) last = last->next;
+	if (last->next == NULL)
 	{
-		int position = 0;
-		GET_HEAD_ITERATOR;
-		while (iterator != NULL)
+		while (count-- > 0)
 		{
-			if (position == index)
-			{
-				iterator->previous->next = iterator->next;
-				iterator->next->previous = iterator->previous;
-				free(iterator);
-				break;
-			}
-			MOVE_NEXT_W_INDEX(position);
+			placeNode(index, first);
+			first = first->next;
 		}
 	}
 	else
 	{
-		int position = list->length - 1;
-		GET_TAIL_ITERATOR;
-		while (iterator != NULL)
+		while (count-- > 0)
 		{
-			if (position == index)
-			{
-				iterator->previous->next = iterator->next;
-				iterator->next->previous = iterator->previous;
-				free(iterator);
-				break;
-			}
-			MOVE_BACK_W_INDEX(position);
+			placeInsideNode(index, last);
+			last = last->previous;
 		}
 	}
-	SYNC_PLUS;
-	list->length--;
-	return TRUE;
 }
 
-// RemoveAllItems
-int remove_all_items(const T item, list_t list)
+// Leaves a tombstone in the slot of a node that is being removed from a list_t,
+// if it has an updated hash index (it becomes stale if the node isn't there)
+static void unindexNode(list_t list, nodePointer node)
 {
-	RETURN_IF_EMPTY(list, -1);
+	struct hashIndex* index = list->index;
+	if (index == NULL || index->stale) return;
+	size_t mask = index->capacity - 1, i = hashItem(node->info) & mask;
+	while (index->slots[i].node != node)
+	{
+		if (index->slots[i].node == NULL && index->slots[i].hash == INDEX_EMPTY)
+		{
+			index->stale = TRUE;
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+	index->slots[i].node = NULL;
+	index->slots[i].hash = INDEX_TOMBSTONE;
+	index->count--;
+}
+
+// Rebuilds the hash index of a list_t after an edit that changed all its
+// items or their order, if it has an updated one
+#define REBUILD_INDEX(list) if ((list)->index != NULL && !(list)->index->stale) rebuildIndex(list)
+
+// Returns the hash index of a list_t, rebuilding it if it is stale, or NULL
+// if the list_t doesn't have one or it couldn't be rebuilt
+static inline struct hashIndex* readyIndex(list_t list)
+{
+	if (list->index == NULL || list->items != NULL) return NULL;
+	if (list->index->stale && !rebuildIndex(list)) return NULL;
+	return list->index;
+}
+
+// Unlinks the node of a slot from its list_t, releasing the node leaves a tombstone in the slot
+static inline void removeSlot(list_t list, int slot)
+{
+	unlinkNode(list, list->index->slots[slot].node);
+}
+
+// EnableHashIndex
+bool_t enable_hash_index(list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+#if defined(LIST_EQUALS) && !defined(LIST_HASH)
+	return FALSE;
+#else
+	if (list == NULL || list->lock != NULL || list->lockFree != NULL || list->arrayStack) return FALSE;
+	if (list->index != NULL) return TRUE;
+	if (!prepareEdit(list, TRUE)) return FALSE;
+	list->index = (struct hashIndex*)calloc(1, sizeof(struct hashIndex));
+	if (list->index == NULL) return FALSE;
+	if (!rebuildIndex(list))
+	{
+		free(list->index);
+		list->index = NULL;
+		return FALSE;
+	}
+	return TRUE;
+#endif
+}
+
+// DisableHashIndex
+bool_t disable_hash_index(list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL || list->index == NULL) return FALSE;
+	free(list->index->slots);
+	free(list->index);
+	list->index = NULL;
+	return TRUE;
+}
+
+/* ================== Bloom filter ================== */
+
+// Number of bits set by each item, and bits of the filter for each item
+#define BLOOM_HASHES 4
+#define BLOOM_BITS_PER_ITEM 16
+
+// Mixes the bits of a hash (with the MurmurHash3 finalizer), so that they are
+// uniform even when LIST_HASH returns the item itself
+static inline uint64_t mixHash(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	return hash ^ (hash >> 33);
+}
+
+// Returns the word of the bloom filter used by an item, and its bits inside mask
+static inline uint64_t* bloomWord(struct bloomFilter* filter, const T item, uint64_t* mask)
+{
+	uint64_t hash = mixHash((uint64_t)hashItem(item));
+	*mask = 0;
+	int i;
+	for (i = 0; i < BLOOM_HASHES; i++) *mask |= 1ULL << ((hash >> (i * 6)) & 63);
+	return filter->words + ((hash >> 32) & (uint64_t)(filter->wordCount - 1));
+}
+
+// Sets the bits of an item inside a bloom filter
+static inline void filterItem(struct bloomFilter* filter, const T item)
+{
+	uint64_t mask;
+	*bloomWord(filter, item, &mask) |= mask;
+	filter->added++;
+}
+
+// Adds the nodes just linked to a list_t to its bloom filter, if it has an updated one
+static void filterNodes(list_t list, nodePointer first, int count)
+{
+	struct bloomFilter* filter = list->filter;
+	if (filter == NULL || filter->stale) return;
+	while (count-- > 0)
+	{
+		filterItem(filter, first->info);
+		first = first->next;
+	}
+}
+
+// Rebuilds the bloom filter of a list_t from its items, with BLOOM_BITS_PER_ITEM
+// bits for each one. Returns FALSE if there isn't enough memory, in this
+// case the filter stays stale
+static bool_t rebuildFilter(list_t list)
+{
+	struct bloomFilter* filter = list->filter;
+	int wordCount = 1;
+	while (wordCount < (1 << 26) && (long long)wordCount * 64 < (long long)list->length * BLOOM_BITS_PER_ITEM) wordCount <<= 1;
+	uint64_t* words = (uint64_t*)calloc(wordCount, sizeof(uint64_t));
+	if (words == NULL)
+	{
+		filter->stale = TRUE;
+		return FALSE;
+	}
+	free(filter->words);
+	filter->words = words;
+	filter->wordCount = wordCount;
+	filter->added = 0;
+	filter->removed = 0;
+	filter->stale = FALSE;
+	SCAN_FORWARD(list, current,
+	{
+		filterItem(filter, SCANNED_ITEM(current));
+	});
+	return TRUE;
+}
+
+// Returns TRUE if the bloom filter of a list_t proves that the list_t doesn't
+// contain the given item, rebuilding the filter first if needed. A list_t
+// without a filter (or whose filter couldn't be rebuilt) never rejects an item
+static bool_t filterRejects(list_t list, const T item)
+{
+	struct bloomFilter* filter = list->filter;
+	if (filter == NULL) return FALSE;
+	if ((filter->stale
+		|| (long long)filter->added * BLOOM_BITS_PER_ITEM > (long long)filter->wordCount * 128
+		|| filter->removed * 2 > filter->added) && !rebuildFilter(list)) return FALSE;
+	filter->stats.checks++;
+	uint64_t mask;
+	if ((*bloomWord(filter, item, &mask) & mask) == mask) return FALSE;
+	filter->stats.rejected++;
+	return TRUE;
+}
+
+// Counts a search for an item that passed the bloom filter of a list_t but wasn't found
+#define FALSE_POSITIVE(list) \
+if ((list)->filter != NULL && !(list)->filter->stale) (list)->filter->stats.false_positives++
+
+// EnableBloomFilter
+bool_t enable_bloom_filter(list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+#if defined(LIST_EQUALS) && !defined(LIST_HASH)
+	return FALSE;
+#else
+	if (list == NULL || list->readonly || list->lock != NULL
+		|| list->lockFree != NULL || list->arrayStack) return FALSE;
+	if (list->filter != NULL) return TRUE;
+	list->filter = (struct bloomFilter*)calloc(1, sizeof(struct bloomFilter));
+	if (list->filter == NULL) return FALSE;
+	if (!rebuildFilter(list))
+	{
+		free(list->filter);
+		list->filter = NULL;
+		return FALSE;
+	}
+	return TRUE;
+#endif
+}
+
+// DisableBloomFilter
+bool_t disable_bloom_filter(list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL || list->filter == NULL) return FALSE;
+	free(list->filter->words);
+	free(list->filter);
+	list->filter = NULL;
+	return TRUE;
+}
+
+// GetBloomStats
+bool_t get_bloom_stats(list_t list, bloom_stats_t* stats)
+{
+	READ_LOCK(list);
+	if (list == NULL || list->filter == NULL || stats == NULL) return FALSE;
+	*stats = list->filter->stats;
+	return TRUE;
+}
+
+static void releaseLockFree(list_t list);
+
+// Clear
+bool_t clear(list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL) return FALSE;
+	if (list->length != 0) SYNC_PLUS;
+	releaseItems(list);
+	while (list->blocks != NULL)
+	{
+		struct nodeBlock* temp = list->blocks;
+		list->blocks = temp->next;
+		free(temp);
+	}
+	list->recycled = NULL;
+	list->capacity = 0;
+	list->readonly = FALSE;
+	list->source = NULL;
+	releaseLockFree(list);
+	releaseStore(list);
+	CLEAR_LIST;
+	if (list->index != NULL)
+	{
+		struct hashIndex* index = list->index;
+		memset(index->slots, 0, sizeof(struct indexSlot) * index->capacity);
+		index->count = 0;
+		index->used = 0;
+		index->stale = FALSE;
+	}
+	if (list->filter != NULL)
+	{
+		struct bloomFilter* filter = list->filter;
+		memset(filter->words, 0, sizeof(uint64_t) * filter->wordCount);
+		filter->added = 0;
+		filter->removed = 0;
+		filter->stale = FALSE;
+	}
+	return TRUE;
+}
+
+// Destroy
+bool_t destroy(list_t* list)
+{
+	if (clear(*list))
+	{
+		disable_hash_index(*list);
+		disable_bloom_filter(*list);
+		if ((*list)->lock != NULL)
+		{
+			pthread_rwlock_destroy((*list)->lock);
+			free((*list)->lock);
+		}
+		free(*list);
+		*list = NULL;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+#define ASSIGN_IF_NOT_NULL(value)    \
+if (result != NULL) *result = value
+
+// DestroySequence
+void destroy_sequence(bool_t* result, list_t** pending)
+{
+	if (pending == NULL)
+	{
+		ASSIGN_IF_NOT_NULL(FALSE);
+		return;
+	}
+	if (*pending == NULL)
+	{
+		ASSIGN_IF_NOT_NULL(FALSE);
+		return;
+	}
+	bool_t destroyed = FALSE;
+	while (*pending)
+	{
+		destroy(*pending);
+		destroyed = TRUE;
+		pending++;
+	}
+	ASSIGN_IF_NOT_NULL(destroyed);
+}
+
+// Returns the node in the given position, starting from the closest end
+static nodePointer nodeAt(list_t list, int index)
+{
+	nodePointer iterator;
+	if (index <= list->length / 2)
+	{
+		iterator = list->head;
+		while (index-- > 0) MOVE_NEXT;
+	}
+	else
+	{
+		iterator = list->tail;
+		index = list->length - 1 - index;
+		while (index-- > 0) MOVE_BACK;
+	}
+	return iterator;
+}
+
+// Appends count items to a list_t, reading them from a source list_t
+// starting from the given node, with a single block allocation
+static void appendFromNodes(list_t list, nodePointer iterator, int count)
+{
+	nodePointer nodes = allocateBlock(list, count);
+	int i;
+	for (i = 0; i < count; i++)
+	{
+		nodes[i].previous = i == 0 ? NULL : nodes + i - 1;
+		nodes[i].info = iterator->info;
+		nodes[i].next = nodes + i + 1;
+		if (i != count - 1) MOVE_NEXT;
+	}
+	spliceNodes(list, nodes, nodes + count - 1, count, list->tail);
+	SYNC_PLUS;
+}
+
+// Appends count items from a source list_t, starting from the given index,
+// with a single block allocation whatever the storage of the source is
+static bool_t appendRange(list_t list, list_t source, int start, int count)
+{
+	if (count <= 0) return TRUE;
+	if (source->items != NULL) return add_range(source->items + start, count, list);
+	ENSURE_APPEND(list, FALSE);
+	appendFromNodes(list, nodeAt(source, start), count);
+	return TRUE;
+}
+
+// Copy
+list_t copy(const list_t source)
+{
+	READ_LOCK(source);
+	if (source == NULL || STALE_SLICE(source)) return NULL;
+	list_t outList = create();
+	appendRange(outList, source, 0, source->length);
+	return outList;
+}
+
+// Snapshot
+list_t snapshot(list_t list)
+{
+	WRITE_LOCK(list, NULL);
+	if (list == NULL) return NULL;
+	list_t outList = create();
+	outList->readonly = TRUE;
+	if (list->length == 0) return outList;
+
+	// Move the memory owned by the list_t inside a new store, if needed
+	if (list->blocks != NULL || list->release != NULL || list->buffer != NULL)
+	{
+		struct nodeStore* store = (struct nodeStore*)malloc(sizeof(struct nodeStore));
+		if (store == NULL)
+		{
+			free(outList);
+			return NULL;
+		}
+		store->references = 1;
+		store->blocks = list->blocks;
+		store->items = list->buffer != NULL ? list->buffer : list->items;
+		store->release = list->buffer != NULL ? free : list->release;
+		store->previous = list->store;
+		list->blocks = NULL;
+		list->release = NULL;
+		list->buffer = NULL;
+		list->reserved = 0;
+		list->store = store;
+
+		// The recycled nodes belong to the store now, new nodes will use new blocks
+		list->recycled = NULL;
+	}
+	list->shared = list->length;
+
+	// The snapshot uses the same nodes or items, bounded by its own length
+	if (list->store != NULL) __atomic_add_fetch(&list->store->references, 1, __ATOMIC_RELAXED);
+	outList->store = list->store;
+	outList->head = list->head;
+	outList->tail = list->tail;
+	outList->items = list->items;
+	outList->length = list->length;
+	outList->source = list->source;
+	outList->sourceSync = list->sourceSync;
+	return outList;
+}
+
+// Slice
+list_t slice(list_t list, int start, int end)
+{
+	READ_LOCK(list);
+	if (list == NULL || STALE_SLICE(list) || start < 0 || end > list->length || start > end) return NULL;
+	list_t outList = create();
+	outList->readonly = TRUE;
+
+	// A slice of a slice borrows the nodes of the original list_t
+	outList->source = list->source != NULL ? list->source : list;
+	outList->sourceSync = list->source != NULL ? list->sourceSync : list->sync;
+	outList->length = end - start;
+	if (start == end) return outList;
+	if (list->items != NULL) outList->items = list->items + start;
+	else
+	{
+		nodePointer iterator = nodeAt(list, start);
+		outList->head = iterator;
+		int count = end - start - 1;
+		while (count-- > 0) MOVE_NEXT;
+		outList->tail = iterator;
+	}
+	return outList;
+}
+
+#ifndef LIST_NOT_NUMERIC
+
+// Create random
+list_t create_random(int length, int min, int max)
+{
+	if (min >= max) return NULL;
+	list_t list = create();
+	if (length <= 0) return list;
+	srand((unsigned)time(NULL));
+	FILL_BLOCK(nodes, length, (T)((rand() % (max - min)) + min));
+	spliceNodes(list, nodes, nodes + length - 1, length, NULL);
+	return list;
+}
+
+#endif
+
+// CreateFrom
+list_t create_from(T* array, int size)
+{
+	if (array == NULL || size <= 0) return NULL;
+	return create_from_n(array, size);
+}
+
+// CreateFromN
+list_t create_from_n(const T* array, int size)
+{
+	if (array == NULL && size > 0) return NULL;
+	list_t outList = create();
+	add_range(array, size, outList);
+	return outList;
+}
+
+// AddRange
+bool_t add_range(const T* array, int size, list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL) return FALSE;
+	return insert_range_at(array, size, list, list->length);
+}
+
+// InsertRangeAt
+bool_t insert_range_at(const T* array, int size, list_t list, int index)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL || array == NULL || size < 0
+		|| index < 0 || index > list->length) return FALSE;
+	if (size == 0) return TRUE;
+	if (!prepareEdit(list, index == list->length)) return FALSE;
+
+	// Get the node that will precede the new ones
+	nodePointer after;
+	if (index == list->length) after = list->tail;
+	else if (index == 0) after = NULL;
+	else if (index <= list->length / 2)
+	{
+		int position = 1;
+		after = list->head;
+		while (position++ < index) after = after->next;
+	}
+	else
+	{
+		int position = list->length;
+		after = list->tail;
+		while (position-- > index) after = after->previous;
+	}
+
+	// Create and link the new nodes in a single pass
+	FILL_BLOCK(nodes, size, array[i]);
+	spliceNodes(list, nodes, nodes + size - 1, size, after);
+	SYNC_PLUS;
+	return TRUE;
+}
+
+// ToArray
+T* to_array(list_t list, int* size)
+{
+	READ_LOCK(list);
+	if (list == NULL || list->length == 0 || STALE_SLICE(list))
+	{
+		*size = list == NULL || STALE_SLICE(list) ? -1 : 0;
+		return NULL;
+	}
+	*size = list->length;
+	T* array = (T*)malloc(sizeof(T) * (*size));
+	if (list->items != NULL)
+	{
+		memcpy(array, list->items, sizeof(T) * (*size));
+		return array;
+	}
+	int i = 0;
+	SCAN_FORWARD(list, current,
+	{
+		array[i++] = SCANNED_ITEM(current);
+	});
+	return array;
+}
+
+// CopyTo
+int copy_to(list_t list, T* dst, int capacity, int start)
+{
+	READ_LOCK(list);
+	if (list == NULL || dst == NULL || capacity < 0 || STALE_SLICE(list)
+		|| start < 0 || start > list->length) return -1;
+	int count = list->length - start;
+	if (count > capacity) count = capacity;
+	if (count == 0) return 0;
+	if (list->items != NULL)
+	{
+		memcpy(dst, list->items + start, sizeof(T) * count);
+		return count;
+	}
+	GET_ITERATOR(nodeAt(list, start));
+	int i;
+	for (i = 0; i < count; i++)
+	{
+		dst[i] = iterator->info;
+		if (i != count - 1) MOVE_NEXT;
+	}
+	return count;
+}
+
+// CreateAdopting
+list_t create_adopting(T* array, int size, void(*free_fn)(void*))
+{
+	if (array == NULL || size < 0) return NULL;
+	list_t outList = create();
+	if (size == 0)
+	{
+		if (free_fn != NULL) free_fn(array);
+		return outList;
+	}
+	outList->items = array;
+	outList->release = free_fn;
+	outList->length = size;
+	return outList;
+}
+
+// ToArrayBorrow
+const T* to_array_borrow(list_t list, int* size)
+{
+	READ_LOCK(list);
+	if (list == NULL || list->items == NULL || STALE_SLICE(list))
+	{
+		*size = -1;
+		return NULL;
+	}
+	*size = list->length;
+	return list->items;
+}
+
+#define CHECK_EMPTY(list) list == NULL || list->length == 0 || STALE_SLICE(list)
+#define NULL_IF_EMPTY(list) if (CHECK_EMPTY(list)) return NULL
+#define RETURN_IF_EMPTY(list, value) if (CHECK_EMPTY(list)) return value
+
+// IsEmpty
+bool_t is_empty(list_t list)
+{
+	READ_LOCK(list);
+	return CHECK_EMPTY(list);
+}
+
+// Checks if a list_t contains an item, using its bloom filter and its hash index
+// when it has them. Used by is_element and by the LINQ functions without locking
+static bool_t containsItem(list_t list, const T item)
+{
+	if (filterRejects(list, item)) return FALSE;
+	struct hashIndex* index = readyIndex(list);
+	if (index != NULL)
+	{
+		if (findSlot(index, item, hashItem(item), -1) >= 0) return TRUE;
+		FALSE_POSITIVE(list);
+		return FALSE;
+	}
+	SCAN_FORWARD(list, current,
+	{
+		if (ITEMS_EQUAL(SCANNED_ITEM(current), item)) return TRUE;
+	});
+	FALSE_POSITIVE(list);
+	return FALSE;
+}
+
+// IsElement
+bool_t is_element(const T item, list_t list)
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	return containsItem(list, item);
+}
+
+// Inline function used inside the get_first and peek functions
+static inline bool_t GetFirst(list_t list, T* result)
+{
+	RETURN_IF_EMPTY(list, FALSE);
+	*result = FIRST_ITEM(list);
+	return TRUE;
+}
+
+// GetFirst
+bool_t get_first(list_t list, T* result)
+{
+	READ_LOCK(list);
+	return GetFirst(list, result);
+}
+
+// GetLast
+bool_t get_last(list_t list, T* result)
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	*result = LAST_ITEM(list);
+	return TRUE;
+}
+
+// Get
+bool_t get(list_t list, int index, T* result)
+{
+	READ_LOCK(list);
+	if (index < 0 || index >= list->length) return FALSE;
+	if (list->items != NULL)
+	{
+		*result = list->items[index];
+		return TRUE;
+	}
+	bool_t fromHead = index <= list->length / 2;
+	if (fromHead)
+	{
+		int position = 0;
+		GET_HEAD_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				*result = iterator->info;
+				return TRUE;
+			}
+			MOVE_NEXT_W_INDEX(position);
+		}
+	}
+	else
+	{
+		int position = list->length - 1;
+		GET_TAIL_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				*result = iterator->info;
+				return TRUE;
+			}
+			MOVE_BACK_W_INDEX(position);
+		}
+	}
+	return FALSE;
+}
+
+// IndexOf
+int index_of(const T item, list_t list)
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, -1);
+	if (filterRejects(list, item)) return -1;
+	struct hashIndex* hashIndex = readyIndex(list);
+	if (hashIndex != NULL)
+	{
+		// Count the nodes before the first equal one, without comparing them
+		int slot = findSlot(hashIndex, item, hashItem(item), -1), position = 0;
+		if (slot < 0)
+		{
+			FALSE_POSITIVE(list);
+			return -1;
+		}
+		GET_HEAD_ITERATOR;
+		while (iterator != hashIndex->slots[slot].node)
+		{
+			MOVE_NEXT_W_INDEX(position);
+		}
+		return position;
+	}
+	int index = 0;
+	SCAN_FORWARD(list, current,
+	{
+		if (ITEMS_EQUAL(SCANNED_ITEM(current), item)) return index;
+		index++;
+	});
+	FALSE_POSITIVE(list);
+	return -1;
+}
+
+// LastIndexOf
+int last_index_of(const T item, list_t list)
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, -1);
+	if (filterRejects(list, item)) return -1;
+	struct hashIndex* hashIndex = readyIndex(list);
+	if (hashIndex != NULL)
+	{
+		// The last equal node is the last one in the probe sequence
+		size_t hash = hashItem(item);
+		int slot = findSlot(hashIndex, item, hash, -1), last = slot, position = list->length - 1;
+		while (slot >= 0)
+		{
+			last = slot;
+			slot = findSlot(hashIndex, item, hash, slot);
+		}
+		if (last < 0)
+		{
+			FALSE_POSITIVE(list);
+			return -1;
+		}
+		GET_TAIL_ITERATOR;
+		while (iterator != hashIndex->slots[last].node)
+		{
+			MOVE_BACK_W_INDEX(position);
+		}
+		return position;
+	}
+	int index = list->length - 1;
+	SCAN_BACKWARD(list, current,
+	{
+		if (ITEMS_EQUAL(SCANNED_ITEM(current), item)) return index;
+		index--;
+	});
+	FALSE_POSITIVE(list);
+	return -1;
+}
+
+// Add
+bool_t add(const T item, list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL) return FALSE;
+	ENSURE_APPEND(list, FALSE);
+	nodePointer newNode = allocateNode(list);
+	newNode->info = item;
+	newNode->next = NULL;
+	if (list->length == 0)
+	{		
+		newNode->previous = NULL;
+		list->head = newNode;
+		list->tail = newNode;
+	}
+	else
+	{
+		newNode->previous = list->tail;
+		list->tail->next = newNode;
+		list->tail = newNode;
+	}
+	list->length++;
+	indexNodes(list, newNode, 1);
+	filterNodes(list, newNode, 1);
+	SYNC_PLUS;
+	return TRUE;
+}
+
+// AddAt
+bool_t add_at(const T item, list_t list, int index)
+{
+	WRITE_LOCK(list, FALSE);
+	if (CHECK_EMPTY(list) || index < 0 || index >= list->length) return FALSE;
+	if (index == 0) return add(item, list);
+	ENSURE_NODES(list, FALSE);
+	bool_t fromHead = index <= list->length / 2;
+	nodePointer newNode = allocateNode(list);
+	newNode->info = item;
+	if (fromHead)
+	{
+		int position = 0;
+		GET_HEAD_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				newNode->previous = iterator->previous;
+				newNode->previous->next = newNode;
+				newNode->next = iterator;
+				iterator->previous = newNode;
+				break;
+			}
+			MOVE_NEXT_W_INDEX(position);
+		}
+	}
+	else
+	{
+		int position = list->length - 1;
+		GET_TAIL_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				newNode->previous = iterator->previous;
+				newNode->previous->next = newNode;
+				newNode->next = iterator;
+				iterator->previous = newNode;
+				break;
+			}
+			MOVE_BACK_W_INDEX(position);
+		}
+	}
+	SYNC_PLUS;
+	list->length++;
+	indexNodes(list, newNode, 1);
+	filterNodes(list, newNode, 1);
+	return TRUE;
+}
+
+// AddAll
+bool_t add_all(list_t target, const list_t source)
+{
+	LOCK_PAIR(target, TRUE, source, FALSE);
+	if (target == NULL || heldLower == LOCK_DENIED || heldHigher == LOCK_DENIED) return FALSE;
+	RETURN_IF_EMPTY(source, FALSE);
+	return appendRange(target, source, 0, source->length);
+}
+
+#define SIZE(list) list == NULL ? -1 : list->length
+
+// Size
+int size(list_t list)
+{
+	READ_LOCK(list);
+	return SIZE(list);
+}
+
+// RemoveItem
+bool_t remove_item(const T item, list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	RETURN_IF_EMPTY(list, FALSE);
+	if (!prepareEdit(list, FALSE)) return FALSE;
+	struct hashIndex* index = readyIndex(list);
+	if (index != NULL)
+	{
+		int slot = findSlot(index, item, hashItem(item), -1);
+		if (slot < 0) return FALSE;
+		removeSlot(list, slot);
+		SYNC_PLUS;
+		return TRUE;
+	}
+	if (list->length == 1)
+	{
+		if (ITEMS_EQUAL(list->head->info, item))
+		{
+			releaseNode(list, list->head);
+			list->head = NULL;
+			list->tail = NULL;
+			list->length = 0;
+			SYNC_PLUS;
+			return TRUE;
+		}
+		else return FALSE;
+	}
+	GET_HEAD_ITERATOR;
+	while (iterator != NULL)
+	{
+		if (ITEMS_EQUAL(iterator->info, item))
+		{
+			// First node inside the list_t
+			if (iterator->previous == NULL)
+			{
+				iterator->next->previous = NULL;
+				list->head = iterator->next;
+			}
+			else if (iterator->next == NULL)
+			{
+				//Last node of the list_t
+				iterator->previous->next = NULL;
+				list->tail = iterator->previous;
+			}
+			else 
+			{
+				// Random position inside the list_t
+				iterator->previous->next = iterator->next;
+				iterator->next->previous = iterator->previous;
+			}			
+			releaseNode(list, iterator);
+			list->length--;
+			SYNC_PLUS;
+			return TRUE;
+		}
+		MOVE_NEXT;
+	}
+	return FALSE;
+}
+
+// RemoveAt
+bool_t remove_at(list_t list, int index)
+{
+	WRITE_LOCK(list, FALSE);
+	RETURN_IF_EMPTY(list, FALSE);
+	if (index < 0 || index >= list->length) return FALSE;
+	ENSURE_NODES(list, FALSE);
+	if (index == 0 && list->length == 1)
+	{
+		releaseNode(list, list->head);
+		list->head = NULL;
+		list->tail = NULL;
+		list->length = 0;
+		SYNC_PLUS;
+		return TRUE;
+	}
+	else if (index == 0 && list->length > 1)
+	{
+		nodePointer temp = list->head;
+		list->head = temp->next;
+		list->head->previous = NULL;
+		releaseNode(list, temp);
+		list->length--;
+		SYNC_PLUS;
+		return TRUE;
+	}
+	else if (index == list->length - 1)
+	{
+		nodePointer temp = list->tail;
+		list->tail = list->tail->previous;
+		list->tail->next = NULL;
+		releaseNode(list, temp);
+		list->length--;
+		SYNC_PLUS;
+		return TRUE;
+	}
+	bool_t fromHead = index <= list->length / 2;
+	if (fromHead)
+	{
+		int position = 0;
+		GET_HEAD_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				iterator->previous->next = iterator->next;
+				iterator->next->previous = iterator->previous;
+				releaseNode(list, iterator);
+				break;
+			}
+			MOVE_NEXT_W_INDEX(position);
+		}
+	}
+	else
+	{
+		int position = list->length - 1;
+		GET_TAIL_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				iterator->previous->next = iterator->next;
+				iterator->next->previous = iterator->previous;
+				releaseNode(list, iterator);
+				break;
+			}
+			MOVE_BACK_W_INDEX(position);
+		}
+	}
+	SYNC_PLUS;
+	list->length--;
+	return TRUE;
+}
+
+// RemoveAllItems
+int remove_all_items(const T item, list_t list)
+{
+	WRITE_LOCK(list, -1);
+	RETURN_IF_EMPTY(list, -1);
+	if (!prepareEdit(list, FALSE)) return -1;
+	struct hashIndex* index = readyIndex(list);
+	if (index != NULL)
+	{
+		// The equal nodes are all inside the same probe sequence
+		size_t hash = hashItem(item);
+		int slot = findSlot(index, item, hash, -1), removed = 0;
+		while (slot >= 0)
+		{
+			removeSlot(list, slot);
+			removed++;
+			slot = findSlot(index, item, hash, slot);
+		}
+		if (removed == 0) return -1;
+		SYNC_PLUS;
+		return removed;
+	}
 	if (list->length == 1)
 	{
-		if (list->head->info == item)
+		if (ITEMS_EQUAL(list->head->info, item))
+		{
+			clear(list);
+			return 1;
+		}
+		else return -1;
+	}
+	GET_HEAD_ITERATOR;
+	int total = 0;
+	while (iterator != NULL)
+	{
+		if (ITEMS_EQUAL(iterator->info, item))
+		{
+			// Last element inside the list_t
+			if (list->length == 1)
+			{
+				clear(list);
+				return total + 1;
+			}
+
+			// Item in last position
+			if (iterator->next == NULL)
+			{
+				// Set previous item as the last one
+				iterator->previous->next = NULL;
+				list->tail = iterator->previous;
+				list->length--;
+				releaseNode(list, iterator);
+				SYNC_PLUS;
+				return total + 1;
+			}
+
+			// First element inside the list_t
+			if (iterator->previous == NULL)
+			{
+				list->head = iterator->next;
+				iterator->next->previous = NULL;			
+			}
+			else 
+			{
+				// Element in a random position
+				iterator->previous->next = iterator->next;
+				iterator->next->previous = iterator->previous;		
+			}		
+			list->length--;
+			nodePointer temp = iterator;
+			MOVE_NEXT;
+			releaseNode(list, temp);
+			total++;
+			SYNC_PLUS;
+		}
+		else MOVE_NEXT;
+	}
+	return total == 0 ? -1 : total;
+}
+
+// ReplaceItem
+bool_t replace_item(const T target, const T replacement, list_t list)
+{
+	WRITE_LOCK(list, FALSE);
+	RETURN_IF_EMPTY(list, FALSE);
+	ENSURE_REPLACE(list, FALSE);
+	GET_HEAD_ITERATOR;
+	while (iterator != NULL)
+	{
+		if (ITEMS_EQUAL(iterator->info, target))
+		{
+			unindexNode(list, iterator);
+			iterator->info = replacement;
+			indexNodes(list, iterator, 1);
+			SYNC_PLUS;
+			return TRUE;
+		}
+		MOVE_NEXT;
+	}
+	return FALSE;
+}
+
+// ReplaceAt
+bool_t replace_at(const T item, list_t list, int index)
+{
+	WRITE_LOCK(list, FALSE);
+	if (list == NULL || index < 0 || index >= list->length) return FALSE;
+	ENSURE_REPLACE(list, FALSE);
+	bool_t fromHead = index <= list->length / 2;
+	if (fromHead)
+	{
+		int position = 0;
+		GET_HEAD_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				unindexNode(list, iterator);
+				iterator->info = item;
+				indexNodes(list, iterator, 1);
+				SYNC_PLUS;
+				return TRUE;
+			}
+			MOVE_NEXT_W_INDEX(position);
+		}
+	}
+	else
+	{
+		int position = list->length - 1;
+		GET_TAIL_ITERATOR;
+		while (iterator != NULL)
+		{
+			if (position == index)
+			{
+				unindexNode(list, iterator);
+				iterator->info = item;
+				indexNodes(list, iterator, 1);
+				SYNC_PLUS;
+				return TRUE;
+			}
+			MOVE_BACK_W_INDEX(position);
+		}
+	}
+	return FALSE;
+}
+
+// ReplaceAllItems
+int replace_all_items(const T target, const T replacement, list_t list)
+{
+	WRITE_LOCK(list, -1);
+	RETURN_IF_EMPTY(list, -1);
+	ENSURE_REPLACE(list, -1);
+	GET_HEAD_ITERATOR;
+	int total = 0;
+	while (iterator != NULL)
+	{
+		if (ITEMS_EQUAL(iterator->info, target))
+		{
+			iterator->info = replacement;
+			total++;
+		}
+		MOVE_NEXT;
+	}
+	if (total == 0) return -1;
+	REBUILD_INDEX(list);
+	SYNC_PLUS;
+	return total;
+}
+
+// Swap
+bool_t swap(list_t list, int index1, int index2)
+{
+	WRITE_LOCK(list, FALSE);
+	RETURN_IF_EMPTY(list, FALSE);
+	if (index1 < 0 || index1 >= list->length || index2 < 0
+		|| index2 >= list->length || index1==index2) return FALSE;
+	T temp1, temp2;
+	get(list, index1, &temp1);
+	get(list, index2, &temp2);
+	if (!replace_at(temp2, list, index1)) return FALSE;
+	replace_at(temp1, list, index2);
+	return TRUE;
+}
+
+/* ================== Text output ================== */
+
+// Size of the block used to write the text to a file
+#define OUTPUT_BLOCK_BYTES 32768
+
+// Destination of the text written by the print functions: either a file,
+// written one block at a time, or a buffer provided by the caller. When
+// a buffer is used, length is the total length of the text even if it
+// didn't fit inside it, and capacity doesn't include the final '\0'
+struct textOutput
+{
+	FILE* file;
+	char* block;
+	char* target;
+	size_t capacity;
+	size_t length;
+};
+
+// Writes the block of a textOutput to its file
+static inline bool_t flushOutput(struct textOutput* output)
+{
+	size_t length = output->length;
+	output->length = 0;
+	return fwrite(output->block, 1, length, output->file) == length;
+}
+
+// Writes count chars to a textOutput
+static inline void writeText(struct textOutput* output, const char* text, size_t count)
+{
+	if (output->file == NULL)
+	{
+		if (output->length < output->capacity)
+		{
+			size_t room = output->capacity - output->length;
+			memcpy(output->target + output->length, text, count < room ? count : room);
+		}
+		output->length += count;
+		return;
+	}
+	if (output->length + count > OUTPUT_BLOCK_BYTES)
+	{
+		flushOutput(output);
+		if (count > OUTPUT_BLOCK_BYTES)
+		{
+			fwrite(text, 1, count, output->file);
+			return;
+		}
+	}
+	memcpy(output->block + output->length, text, count);
+	output->length += count;
+}
+
+// Number of bytes always copied by writeShort
+#define SHORT_TEXT_BYTES 32
+
+// Writes up to SHORT_TEXT_BYTES chars with a copy of a fixed size, that the
+// compiler can inline. text must have SHORT_TEXT_BYTES readable bytes
+static inline void writeShort(struct textOutput* output, const char* text, size_t count)
+{
+	if (output->file != NULL)
+	{
+		if (output->length + SHORT_TEXT_BYTES > OUTPUT_BLOCK_BYTES) flushOutput(output);
+		memcpy(output->block + output->length, text, SHORT_TEXT_BYTES);
+	}
+	else if (output->length + SHORT_TEXT_BYTES <= output->capacity)
+	{
+		memcpy(output->target + output->length, text, SHORT_TEXT_BYTES);
+	}
+	else
+	{
+		writeText(output, text, count);
+		return;
+	}
+	output->length += count;
+}
+
+// The ways an item can be formatted: the generic one uses snprintf with
+// the original pattern, the others are used when the pattern has a single
+// %d, %i, %u or %f conversion (with an optional precision) that matches T
+typedef enum { FORMAT_GENERIC, FORMAT_SIGNED, FORMAT_UNSIGNED, FORMAT_FIXED } formatKind;
+
+// A pattern split around its conversion, so that it's only parsed once
+struct itemFormat
+{
+	formatKind kind;
+	const char* pattern;
+	const char* prefix;
+	size_t prefixLength;
+	const char* suffix;
+	size_t suffixLength;
+	int precision;
+};
+
+// Checks if T is the given type
+#define T_IS(type) __builtin_types_compatible_p(T, type)
+
+// Reads an item as the given type (only used when T_IS(type) is TRUE)
+#define READ_AS(item, type)                                                   \
+{                                                                             \
+	type value = 0;                                                           \
+	memcpy(&value, item, sizeof(T) < sizeof(type) ? sizeof(T) : sizeof(type)); \
+	return value;                                                             \
+}
+
+// Gets the value of an item that can be formatted with %d or %i
+static inline long long signedValue(const T* item)
+{
+	if (T_IS(int)) READ_AS(item, int);
+	if (T_IS(short)) READ_AS(item, short);
+	if (T_IS(long)) READ_AS(item, long);
+	READ_AS(item, long long);
+}
+
+// Gets the value of an item that can be formatted with %u
+static inline unsigned long long unsignedValue(const T* item)
+{
+	if (T_IS(unsigned int)) READ_AS(item, unsigned int);
+	if (T_IS(unsigned short)) READ_AS(item, unsigned short);
+	if (T_IS(unsigned long)) READ_AS(item, unsigned long);
+	READ_AS(item, unsigned long long);
+}
+
+// Gets the value of an item that can be formatted with %f
+static inline double floatValue(const T* item)
+{
+	if (T_IS(float)) READ_AS(item, float);
+	READ_AS(item, double);
+}
+
+// Splits a pattern and checks if its conversion can use a specialized formatting
+static void parseFormat(const char* pattern, struct itemFormat* format)
+{
+	format->kind = FORMAT_GENERIC;
+	format->pattern = pattern;
+	format->prefix = format->suffix = NULL;
+	format->prefixLength = format->suffixLength = 0;
+	const char* conversion = strchr(pattern, '%');
+	if (conversion == NULL) return;
+
+	// Optional precision and length modifiers
+	const char* end = conversion + 1;
+	int precision = -1, longs = 0;
+	if (*end == '.')
+	{
+		precision = 0;
+		for (end++; *end >= '0' && *end <= '9'; end++)
+		{
+			precision = precision * 10 + *end - '0';
+			if (precision > 9) return;
+		}
+	}
+	while (*end == 'l' && longs < 2)
+	{
+		longs++;
+		end++;
+	}
+
+	// Check if the conversion matches T, and that it is the only one
+	formatKind kind = FORMAT_GENERIC;
+	if ((*end == 'd' || *end == 'i') && precision == -1
+		&& ((longs == 0 && (T_IS(int) || T_IS(short)))
+			|| (longs == 1 && T_IS(long))
+			|| (longs == 2 && T_IS(long long)))) kind = FORMAT_SIGNED;
+	else if (*end == 'u' && precision == -1
+		&& ((longs == 0 && (T_IS(unsigned int) || T_IS(unsigned short)))
+			|| (longs == 1 && T_IS(unsigned long))
+			|| (longs == 2 && T_IS(unsigned long long)))) kind = FORMAT_UNSIGNED;
+	else if (*end == 'f' && longs < 2 && (T_IS(double) || T_IS(float))) kind = FORMAT_FIXED;
+	if (kind == FORMAT_GENERIC || strchr(end + 1, '%') != NULL) return;
+	format->kind = kind;
+	format->prefix = pattern;
+	format->prefixLength = conversion - pattern;
+	format->suffix = end + 1;
+	format->suffixLength = strlen(end + 1);
+	format->precision = precision == -1 ? 6 : precision;
+}
+
+// Pairs of decimal digits from 00 to 99, used to convert two digits at a time
+static const char digitPairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+// Writes the digits of a value before end, and returns a pointer to the first one
+static inline char* formatDigits(unsigned long long value, char* end)
+{
+	while (value > UINT32_MAX)
+	{
+		end -= 2;
+		memcpy(end, digitPairs + value % 100 * 2, 2);
+		value /= 100;
+	}
+
+	// Use 32 bit divisions for the remaining digits, as they're faster
+	uint32_t small = (uint32_t)value;
+	while (small >= 100)
+	{
+		end -= 2;
+		memcpy(end, digitPairs + small % 100 * 2, 2);
+		small /= 100;
+	}
+	if (small >= 10)
+	{
+		end -= 2;
+		memcpy(end, digitPairs + small * 2, 2);
+	}
+	else *--end = (char)('0' + small);
+	return end;
+}
+
+// Writes a value with the given number of decimals before end, and returns
+// a pointer to the first char. Returns NULL if the value is too large, or if
+// it's so close to a tie that only snprintf can round it like printf does
+static char* formatFixed(double value, int precision, char* end)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+	double scaled = (value < 0 ? -value : value) * powers[precision];
+
+	// Below 2^40 the error of scaled is less than 2^-13, much smaller than the margin around the ties
+	if (!(scaled < 1099511627776.0)) return NULL;
+	unsigned long long units = (unsigned long long)scaled;
+	double fraction = scaled - (double)units;
+	if (fraction > 0.499 && fraction < 0.501) return NULL;
+	if (fraction > 0.5) units++;
+	char* start = end;
+	if (precision > 0)
+	{
+		int i;
+		for (i = 0; i < precision; i++)
+		{
+			*--start = (char)('0' + units % 10);
+			units /= 10;
+		}
+		*--start = '.';
+	}
+	start = formatDigits(units, start);
+	if (__builtin_signbit(value)) *--start = '-';
+	return start;
+}
+
+// Writes a single item using snprintf
+static void writeGeneric(struct textOutput* output, const char* pattern, T item)
+{
+	char text[128];
+	int length = snprintf(text, sizeof(text), pattern, item);
+	if (length < 0) return;
+	if ((size_t)length < sizeof(text))
+	{
+		writeText(output, text, length);
+		return;
+	}
+	char* large = (char*)malloc(length + 1);
+	if (large == NULL) return;
+	snprintf(large, length + 1, pattern, item);
+	writeText(output, large, length);
+	free(large);
+}
+
+// Writes a single item to a textOutput
+static inline void writeItem(struct textOutput* output, const struct itemFormat* format, T item)
+{
+	// The longest text is a value with 13 digits and 9 decimals, so even the
+	// first char is followed by SHORT_TEXT_BYTES readable bytes
+	char text[64];
+	char* end = text + sizeof(text) - SHORT_TEXT_BYTES;
+	char* start = NULL;
+	if (format->kind == FORMAT_SIGNED)
+	{
+		long long value = signedValue(&item);
+		start = formatDigits(value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value, end);
+		if (value < 0) *--start = '-';
+	}
+	else if (format->kind == FORMAT_UNSIGNED) start = formatDigits(unsignedValue(&item), end);
+	else if (format->kind == FORMAT_FIXED) start = formatFixed(floatValue(&item), format->precision, end);
+	if (start == NULL)
+	{
+		writeGeneric(output, format->pattern, item);
+		return;
+	}
+	if (format->prefixLength != 0) writeText(output, format->prefix, format->prefixLength);
+	writeShort(output, start, end - start);
+	if (format->suffixLength != 0) writeText(output, format->suffix, format->suffixLength);
+}
+
+// Writes all the items of a list_t, with an optional separator between them
+static void writeItems(struct textOutput* output, const char* pattern, list_t list, const char* separator)
+{
+	struct itemFormat format;
+	parseFormat(pattern, &format);
+	if (separator == NULL) separator = "";
+	size_t separatorLength = strlen(separator);
+
+	// Copy a short separator in a padded buffer, so that it can be written with writeShort
+	char padded[SHORT_TEXT_BYTES] = { 0 };
+	bool_t shortSeparator = separatorLength <= SHORT_TEXT_BYTES;
+	if (shortSeparator) memcpy(padded, separator, separatorLength);
+	int left = list->length;
+	SCAN_FORWARD(list, current,
+	{
+		writeItem(output, &format, SCANNED_ITEM(current));
+		if (--left == 0 || separatorLength == 0) continue;
+		if (shortSeparator) writeShort(output, padded, separatorLength);
+		else writeText(output, separator, separatorLength);
+	});
+}
+
+// Writes a list_t with the formatted_print style
+static bool_t writeFormatted(struct textOutput* output, const char* pattern, list_t list)
+{
+	if (list == NULL)
+	{
+		writeText(output, "NULL list", 9);
+		return FALSE;
+	}
+	if (list->length == 0)
+	{
+		writeText(output, "Empty list", 10);
+		return FALSE;
+	}
+	writeItems(output, pattern, list, ", ");
+	return TRUE;
+}
+
+// Initializes a textOutput that writes to a file using the given block
+#define FILE_OUTPUT(output, target, buffer) \
+char buffer[OUTPUT_BLOCK_BYTES];            \
+struct textOutput output = { target, buffer, NULL, 0, 0 }
+
+// Initializes a textOutput that writes to a buffer with the given size
+#define BUFFER_OUTPUT(output, buffer, size) \
+struct textOutput output = { NULL, NULL, buffer, size > 0 ? (size_t)size - 1 : 0, 0 }
+
+// Adds the final '\0' to the buffer of a textOutput and returns the length of the text
+static int closeBuffer(struct textOutput* output, int size)
+{
+	if (size > 0) output->target[output->length < output->capacity ? output->length : output->capacity] = '\0';
+	return output->length > INT_MAX ? INT_MAX : (int)output->length;
+}
+
+// FormattedPrint
+bool_t formatted_print(char* pattern, list_t list)
+{
+	return formatted_print_to(stdout, pattern, list);
+}
+
+// FormattedPrintTo
+bool_t formatted_print_to(FILE* file, const char* pattern, list_t list)
+{
+	READ_LOCK(list);
+	if (file == NULL || pattern == NULL) return FALSE;
+	FILE_OUTPUT(output, file, block);
+	bool_t result = writeFormatted(&output, pattern, list);
+	return flushOutput(&output) && result;
+}
+
+// FormattedPrintBuffer
+int formatted_print_buffer(char* buffer, int size, const char* pattern, list_t list)
+{
+	READ_LOCK(list);
+	if ((buffer == NULL && size > 0) || size < 0 || pattern == NULL) return -1;
+	BUFFER_OUTPUT(output, buffer, size);
+	writeFormatted(&output, pattern, list);
+	return closeBuffer(&output, size);
+}
+
+// Print
+bool_t print(char* pattern, list_t list)
+{
+	return print_to(stdout, pattern, list);
+}
+
+// PrintTo
+bool_t print_to(FILE* file, const char* pattern, list_t list)
+{
+	READ_LOCK(list);
+	if (list == NULL || file == NULL || pattern == NULL) return FALSE;
+	FILE_OUTPUT(output, file, block);
+	writeItems(&output, pattern, list, NULL);
+	return flushOutput(&output);
+}
+
+// PrintBuffer
+int print_buffer(char* buffer, int size, const char* pattern, list_t list)
+{
+	READ_LOCK(list);
+	if (list == NULL || (buffer == NULL && size > 0) || size < 0 || pattern == NULL) return -1;
+	BUFFER_OUTPUT(output, buffer, size);
+	writeItems(&output, pattern, list, NULL);
+	return closeBuffer(&output, size);
+}
+
+#ifndef LIST_NOT_NUMERIC
+
+/* ================== Text parsing ================== */
+
+// Checks if the 8 chars inside a chunk are all decimal digits
+static inline bool_t eightDigits(uint64_t chunk)
+{
+	return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+		| (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+// Converts 8 digits loaded from memory on a little endian machine, combining
+// pairs of digits, then pairs of those pairs and so on with 3 multiplications
+static inline uint64_t parseEightDigits(uint64_t chunk)
+{
+	chunk = (chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+	chunk = (chunk & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+	return (chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+
+// Gets the largest absolute value of a T number with the given sign
+static inline unsigned long long magnitudeLimit(bool_t negative)
+{
+	unsigned long long max = sizeof(T) >= sizeof(unsigned long long)
+		? ULLONG_MAX : (1ULL << (sizeof(T) * CHAR_BIT)) - 1;
+	if ((T)-1 > (T)0) return negative ? 0 : max;
+	return negative ? max / 2 + 1 : max / 2;
+}
+
+// Adds a digit (or a group of digits) to a value, or returns FALSE if it gets too large
+#define APPEND_DIGITS(value, digits, base, limit) \
+(value <= limit / base && (value *= base, digits <= limit - value) && (value += digits, TRUE))
+
+// Skips the spaces, the tabs and the '\r' chars
+#define SKIP_BLANKS(position, end) \
+while (position != end && (*position == ' ' || *position == '\t' || *position == '\r')) position++
+
+// ParseList
+list_t parse_list(const char* buffer, int length, char separator, int* error)
+{
+	if (error != NULL) *error = -1;
+	if (buffer == NULL || length < 0) return NULL;
+	const char* position = buffer;
+	const char* end = buffer + length;
+	int count = 0, capacity = 16 + length / 8;
+	T* items = (T*)malloc(sizeof(T) * capacity);
+	if (items == NULL) return NULL;
+	const char* wrong = NULL;
+	while (TRUE)
+	{
+		SKIP_BLANKS(position, end);
+		if (position == end) break;
+
+		// Optional sign
+		const char* start = position;
+		bool_t negative = *position == '-';
+		if (negative || *position == '+') position++;
+		unsigned long long limit = magnitudeLimit(negative), value = 0;
+		const char* digits = position;
+		bool_t valid = TRUE;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		// Check and convert 8 digits at a time, while they are available
+		while (valid && end - position >= 8)
+		{
+			uint64_t chunk;
+			memcpy(&chunk, position, sizeof(chunk));
+			if (!eightDigits(chunk)) break;
+			uint64_t group = parseEightDigits(chunk);
+			valid = APPEND_DIGITS(value, group, 100000000ULL, limit);
+			position += 8;
+		}
+#endif
+		while (valid && position != end && *position >= '0' && *position <= '9')
+		{
+			unsigned long long digit = *position++ - '0';
+			valid = APPEND_DIGITS(value, digit, 10ULL, limit);
+		}
+		if (!valid)
+		{
+			wrong = start;
+			break;
+		}
+		if (position == digits)
+		{
+			wrong = position;
+			break;
+		}
+
+		// Store the value, growing the array if needed
+		if (count == capacity)
+		{
+			capacity *= 2;
+			T* larger = (T*)realloc(items, sizeof(T) * capacity);
+			if (larger == NULL)
+			{
+				free(items);
+				return NULL;
+			}
+			items = larger;
+		}
+		items[count++] = (T)(negative ? (long long)(0ULL - value) : (long long)value);
+
+		// Move to the next value
+		SKIP_BLANKS(position, end);
+		if (position == end) break;
+		if (*position != separator && *position != '\n')
+		{
+			wrong = position;
+			break;
+		}
+		position++;
+	}
+	if (wrong != NULL)
+	{
+		if (error != NULL) *error = (int)(wrong - buffer);
+		free(items);
+		return NULL;
+	}
+	if (count == 0)
+	{
+		free(items);
+		return create();
+	}
+	T* trimmed = (T*)realloc(items, sizeof(T) * count);
+	return create_adopting(trimmed != NULL ? trimmed : items, count, free);
+}
+
+#endif
+
+/* ============================================================================
+*  Serialization
+*  ========================================================================= */
+
+// Magic number, endianness marker and chunk size used by the binary format
+#define LIST_MAGIC "LSTT"
+#define LIST_ENDIANNESS 0x01020304u
+#define CHUNK_BYTES 65536
+
+/* ---------------------------------------------------------------------
+*  listHeader
+*  ---------------------------------------------------------------------
+*  Description:
+*    The header of a serialized list_t: it is followed by the raw block
+*    with all the items. The endianness field stores LIST_ENDIANNESS with
+*    the byte order of the machine that saved the list_t, and the
+*    checksum is calculated on the raw block of items. */
+struct listHeader
+{
+	char magic[4];
+	uint32_t endianness;
+	uint32_t itemSize;
+	uint32_t reserved;
+	uint64_t length;
+	uint64_t checksum;
+};
+
+// Updates a Fletcher-style checksum (with 32 bits sums) with the given bytes:
+// the two sums are stored inside the low and high words of the checksum.
+// All the blocks except the last one must have a length multiple of 4
+static uint64_t updateChecksum(uint64_t checksum, const void* data, size_t bytes)
+{
+	uint32_t low = (uint32_t)checksum, high = (uint32_t)(checksum >> 32);
+	const unsigned char* pointer = (const unsigned char*)data;
+	while (bytes >= sizeof(uint32_t))
+	{
+		uint32_t word;
+		memcpy(&word, pointer, sizeof(word));
+		low += word;
+		high += low;
+		pointer += sizeof(word);
+		bytes -= sizeof(word);
+	}
+	if (bytes > 0)
+	{
+		uint32_t word = 0;
+		memcpy(&word, pointer, bytes);
+		low += word;
+		high += low;
+	}
+	return ((uint64_t)high << 32) | low;
+}
+
+// Copies the nodes of a list_t inside a buffer, one chunk at a time, and
+// either writes each chunk to the file or uses it to update the checksum.
+// Returns FALSE if the buffer can't be allocated or a chunk isn't written
+static bool_t processChunks(list_t list, FILE* file, uint64_t* checksum)
+{
+	// Use a multiple of 4 items, so that each chunk is a multiple of 4 bytes
+	int capacity = (int)(CHUNK_BYTES / sizeof(T)) & ~3;
+	if (capacity == 0) capacity = 4;
+	T* buffer = (T*)malloc(sizeof(T) * capacity);
+	if (buffer == NULL) return FALSE;
+	nodePointer iterator = list->head;
+	int left = list->length;
+	bool_t success = TRUE;
+	while (left > 0 && success)
+	{
+		int count = left < capacity ? left : capacity, i;
+		for (i = 0; i < count; i++)
+		{
+			buffer[i] = iterator->info;
+			if (--left != 0) MOVE_NEXT;
+		}
+		if (file != NULL) success = fwrite(buffer, sizeof(T), count, file) == (size_t)count;
+		else *checksum = updateChecksum(*checksum, buffer, sizeof(T) * count);
+	}
+	free(buffer);
+	return success;
+}
+
+// SaveList
+bool_t save_list(list_t list, FILE* file)
+{
+	READ_LOCK(list);
+	if (list == NULL || file == NULL) return FALSE;
+	struct listHeader header;
+	memcpy(header.magic, LIST_MAGIC, sizeof(header.magic));
+	header.endianness = LIST_ENDIANNESS;
+	header.itemSize = (uint32_t)sizeof(T);
+	header.reserved = 0;
+	header.length = (uint64_t)list->length;
+	header.checksum = 0;
+
+	// Contiguous storage, the items can be written directly
+	if (list->items != NULL)
+	{
+		header.checksum = updateChecksum(0, list->items, sizeof(T) * list->length);
+		if (fwrite(&header, sizeof(header), 1, file) != 1) return FALSE;
+		return fwrite(list->items, sizeof(T), list->length, file) == (size_t)list->length;
+	}
+
+	// Calculate the checksum first, so that the file doesn't need to be seekable
+	if (!processChunks(list, NULL, &header.checksum)) return FALSE;
+	if (fwrite(&header, sizeof(header), 1, file) != 1) return FALSE;
+	return processChunks(list, file, NULL);
+}
+
+// LoadList
+list_t load_list(FILE* file)
+{
+	if (file == NULL) return NULL;
+	struct listHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+		|| memcmp(header.magic, LIST_MAGIC, sizeof(header.magic)) != 0
+		|| header.endianness != LIST_ENDIANNESS
+		|| header.itemSize != sizeof(T)
+		|| header.length > INT_MAX) return NULL;
+	int length = (int)header.length;
+	if (length == 0) return header.checksum == 0 ? create() : NULL;
+
+	// Read the whole block and let the new list_t adopt it
+	T* items = (T*)malloc(sizeof(T) * length);
+	if (items == NULL) return NULL;
+	if (fread(items, sizeof(T), length, file) != (size_t)length
+		|| updateChecksum(0, items, sizeof(T) * length) != header.checksum)
+	{
+		free(items);
+		return NULL;
+	}
+	return create_adopting(items, length, free);
+}
+
+// Unmaps the file view of a list_t created with map_list()
+static void unmapItems(void* items)
+{
+	struct listHeader* header = (struct listHeader*)((char*)items - sizeof(struct listHeader));
+#ifdef _WIN32
+	UnmapViewOfFile(header);
+#else
+	munmap(header, sizeof(struct listHeader) + sizeof(T) * (size_t)header->length);
+#endif
+}
+
+// MapList
+list_t map_list(const char* path)
+{
+	if (path == NULL) return NULL;
+	struct listHeader header;
+	uint64_t fileBytes;
+	size_t size;
+	void* view;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return NULL;
+	LARGE_INTEGER fileSize;
+	DWORD bytesRead;
+	if (!GetFileSizeEx(file, &fileSize)
+		|| !ReadFile(file, &header, sizeof(header), &bytesRead, NULL)
+		|| bytesRead != sizeof(header))
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+	fileBytes = (uint64_t)fileSize.QuadPart;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0) return NULL;
+	struct stat info;
+	if (fstat(file, &info) != 0 || read(file, &header, sizeof(header)) != sizeof(header))
+	{
+		close(file);
+		return NULL;
+	}
+	fileBytes = (uint64_t)info.st_size;
+#endif
+
+	// Validate the header and make sure the file actually contains all the items
+	bool_t valid = memcmp(header.magic, LIST_MAGIC, sizeof(header.magic)) == 0
+		&& header.endianness == LIST_ENDIANNESS
+		&& header.itemSize == sizeof(T)
+		&& header.length <= INT_MAX
+		&& fileBytes >= sizeof(header) + sizeof(T) * header.length;
+	size = sizeof(header) + sizeof(T) * (size_t)header.length;
+	if (!valid || header.length == 0)
+	{
+#ifdef _WIN32
+		CloseHandle(file);
+#else
+		close(file);
+#endif
+		return valid ? create() : NULL;
+	}
+
+	// Map only the header and the items, the mapping stays valid after closing the file
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	view = mapping == NULL ? NULL : MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+	if (mapping != NULL) CloseHandle(mapping);
+	CloseHandle(file);
+	if (view == NULL) return NULL;
+#else
+	view = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if (view == MAP_FAILED) return NULL;
+#endif
+	list_t outList = create_adopting((T*)((char*)view + sizeof(header)), (int)header.length, unmapItems);
+	outList->readonly = TRUE;
+	return outList;
+}
+
+/* ================== Streams ================== */
+
+// Size in bytes of each stream buffer
+#define STREAM_CHUNK_BYTES (1 << 20)
+
+// Fills a buffer with the next records of a stream and returns their number,
+// or -1 if there was a read error. The reads interrupted by a signal are retried
+static int readRecords(list_stream_t stream, T* buffer)
+{
+	size_t total = sizeof(T) * stream->capacity, done = 0;
+	while (done < total)
+	{
+		if (stream->file != NULL)
+		{
+			done += fread((char*)buffer + done, 1, total - done, stream->file);
+			if (done == total || feof(stream->file)) break;
+			if (errno != EINTR) return -1;
+			clearerr(stream->file);
+		}
+		else
+		{
+			int bytes = (int)read(stream->fd, (char*)buffer + done, (unsigned int)(total - done));
+			if (bytes == 0) break;
+			if (bytes < 0)
+			{
+				if (errno == EINTR) continue;
+				return -1;
+			}
+			done += bytes;
+		}
+	}
+	return (int)(done / sizeof(T));
+}
+
+// Background thread that keeps filling the buffers of a stream
+static void* streamReader(void* argument)
+{
+	list_stream_t stream = (list_stream_t)argument;
+	int index = 0, count;
+	do
+	{
+		// Wait for the buffer to be released by the consumer
+		pthread_mutex_lock(&stream->lock);
+		while (stream->counts[index] != -1 && !stream->stopped)
+		{
+			pthread_cond_wait(&stream->changed, &stream->lock);
+		}
+		bool_t stopped = stream->stopped;
+		pthread_mutex_unlock(&stream->lock);
+		if (stopped) break;
+
+		// Fill it outside of the lock, then pass it to the consumer
+		count = readRecords(stream, stream->buffers[index]);
+		pthread_mutex_lock(&stream->lock);
+		if (count < 0)
+		{
+			// The input ends here, and the functions that reach its end fail
+			stream->failed = TRUE;
+			count = 0;
+		}
+		stream->counts[index] = count;
+		pthread_cond_broadcast(&stream->changed);
+		pthread_mutex_unlock(&stream->lock);
+		index ^= 1;
+	} while (count > 0);
+	return NULL;
+}
+
+// Creates a stream and starts its reader thread
+static list_stream_t openStreamHelper(FILE* file, int fd)
+{
+	list_stream_t stream = (list_stream_t)malloc(sizeof(struct listStream));
+	if (stream == NULL) return NULL;
+	stream->file = file;
+	stream->fd = fd;
+	stream->capacity = STREAM_CHUNK_BYTES / sizeof(T);
+	if (stream->capacity == 0) stream->capacity = 1;
+	stream->buffers[0] = (T*)malloc(sizeof(T) * stream->capacity);
+	stream->buffers[1] = (T*)malloc(sizeof(T) * stream->capacity);
+	stream->counts[0] = stream->counts[1] = -1;
+	stream->current = 0;
+	stream->position = 0;
+	stream->stopped = FALSE;
+	stream->failed = FALSE;
+	pthread_mutex_init(&stream->lock, NULL);
+	pthread_cond_init(&stream->changed, NULL);
+	if (stream->buffers[0] == NULL || stream->buffers[1] == NULL
+		|| pthread_create(&stream->reader, NULL, streamReader, stream) != 0)
+	{
+		pthread_mutex_destroy(&stream->lock);
+		pthread_cond_destroy(&stream->changed);
+		free(stream->buffers[0]);
+		free(stream->buffers[1]);
+		free(stream);
+		return NULL;
+	}
+	return stream;
+}
+
+// OpenStream
+list_stream_t open_stream(FILE* file)
+{
+	if (file == NULL) return NULL;
+	return openStreamHelper(file, -1);
+}
+
+// OpenStreamFd
+list_stream_t open_stream_fd(int fd)
+{
+	if (fd < 0) return NULL;
+	return openStreamHelper(NULL, fd);
+}
+
+// CloseStream
+bool_t close_stream(list_stream_t* stream)
+{
+	if (stream == NULL || *stream == NULL) return FALSE;
+	list_stream_t target = *stream;
+	pthread_mutex_lock(&target->lock);
+	target->stopped = TRUE;
+	pthread_cond_broadcast(&target->changed);
+	pthread_mutex_unlock(&target->lock);
+	pthread_join(target->reader, NULL);
+	pthread_mutex_destroy(&target->lock);
+	pthread_cond_destroy(&target->changed);
+	free(target->buffers[0]);
+	free(target->buffers[1]);
+	free(target);
+	*stream = NULL;
+	return TRUE;
+}
+
+// Gives the records of the current buffer that haven't been used yet,
+// waiting for the reader thread if needed, or returns 0 if the input is over
+static int takeRecords(list_stream_t stream, const T** records)
+{
+	pthread_mutex_lock(&stream->lock);
+	int current = stream->current;
+	if (stream->counts[current] > 0 && stream->position == stream->counts[current])
+	{
+		// The current buffer has been used, give it back to the reader thread
+		stream->counts[current] = -1;
+		pthread_cond_broadcast(&stream->changed);
+		current = stream->current ^= 1;
+		stream->position = 0;
+	}
+	while (stream->counts[current] == -1)
+	{
+		pthread_cond_wait(&stream->changed, &stream->lock);
+	}
+	int count = stream->counts[current] - stream->position;
+	*records = stream->buffers[current] + stream->position;
+	pthread_mutex_unlock(&stream->lock);
+	return count;
+}
+
+// Loops over the remaining records of a stream, assigning each of them to item.
+// The loop body can use return, and the next loop starts after the last record
+#define SCAN_STREAM(stream, item, ...)                                \
+const T* streamRecords;                                               \
+int streamLeft;                                                       \
+while ((streamLeft = takeRecords(stream, &streamRecords)) > 0)        \
+{                                                                     \
+	for (; streamLeft > 0; streamLeft--)                              \
+	{                                                                 \
+		SCAN_ITEM(item, *streamRecords++);                            \
+		stream->position++;                                           \
+		__VA_ARGS__                                                   \
+	}                                                                 \
+}
+
+// StreamCount
+int stream_count(list_stream_t stream, bool_t(*expression)(item_arg_t))
+{
+	if (stream == NULL) return -1;
+	int total = 0;
+	SCAN_STREAM(stream, current,
+	{
+		if (expression(SCANNED_ARG(current))) total++;
+	});
+	return stream->failed ? -1 : total;
+}
+
+// StreamSum
+int stream_sum(list_stream_t stream, int(*expression)(item_arg_t))
+{
+	if (stream == NULL) return 0;
+	int total = 0;
+	SCAN_STREAM(stream, current,
+	{
+		total += expression(SCANNED_ARG(current));
+	});
+	return stream->failed ? 0 : total;
+}
+
+// StreamFirstOrDefault
+bool_t stream_first_or_default(list_stream_t stream, T* result, bool_t(*expression)(item_arg_t))
+{
+	if (stream == NULL) return FALSE;
+	SCAN_STREAM(stream, current,
+	{
+		if (expression(SCANNED_ARG(current)))
+		{
+			*result = SCANNED_ITEM(current);
+			return TRUE;
+		}
+	});
+	return FALSE;
+}
+
+// StreamForEach
+bool_t stream_for_each(list_stream_t stream, void(*expression)(item_arg_t))
+{
+	if (stream == NULL) return FALSE;
+	SCAN_STREAM(stream, current,
+	{
+		expression(SCANNED_ARG(current));
+	});
+	return !stream->failed;
+}
+
+#ifndef LIST_NOT_NUMERIC
+
+/* ================== Frozen lists ================== */
+
+// Number of items inside each block of a frozen list
+#define FROZEN_BLOCK_ITEMS 128
+
+// Appends an unsigned varint to a buffer that has at least 10 free bytes
+static inline size_t writeVarint(unsigned char* target, unsigned long long value)
+{
+	size_t length = 0;
+	while (value >= 0x80)
+	{
+		target[length++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	target[length++] = (unsigned char)value;
+	return length;
+}
+
+// Reads an unsigned varint and moves the source pointer after it
+static inline unsigned long long readVarint(const unsigned char** source)
+{
+	const unsigned char* position = *source;
+	unsigned long long value = *position & 0x7F;
+	int shift = 7;
+	while (*position++ & 0x80)
+	{
+		value |= (unsigned long long)(*position & 0x7F) << shift;
+		shift += 7;
+	}
+	*source = position;
+	return value;
+}
+
+// Decodes the items of a block and returns their number
+static int decodeBlock(frozen_list_t frozen, int index, T* items)
+{
+	int count = index == frozen->blockCount - 1
+		? frozen->length - index * FROZEN_BLOCK_ITEMS : FROZEN_BLOCK_ITEMS;
+	const unsigned char* position = frozen->data + frozen->blocks[index].offset;
+	unsigned long long value = (unsigned long long)frozen->blocks[index].first;
+	int i;
+	items[0] = (T)(long long)value;
+	for (i = 1; i < count; i++)
+	{
+		// Undo the zigzag encoding, the sum wraps just like the difference did
+		unsigned long long zigzag = readVarint(&position);
+		value += (zigzag >> 1) ^ (0ULL - (zigzag & 1));
+		items[i] = (T)(long long)value;
+	}
+	return count;
+}
+
+// Loops over all the items of a frozen list, decoding a block at a time
+#define SCAN_FROZEN(frozen, item, ...)                                  \
+{                                                                       \
+	T frozenItems[FROZEN_BLOCK_ITEMS];                                  \
+	int frozenBlock;                                                    \
+	for (frozenBlock = 0; frozenBlock < frozen->blockCount; frozenBlock++) \
+	{                                                                   \
+		int frozenCount = decodeBlock(frozen, frozenBlock, frozenItems), frozenIndex; \
+		for (frozenIndex = 0; frozenIndex < frozenCount; frozenIndex++) \
+		{                                                               \
+			SCAN_ITEM(item, frozenItems[frozenIndex]);                  \
+			__VA_ARGS__                                                 \
+		}                                                               \
+	}                                                                   \
+}
+
+// Freeze
+frozen_list_t freeze(list_t list)
+{
+	READ_LOCK(list);
+	if (list == NULL) return NULL;
+	frozen_list_t frozen = (frozen_list_t)malloc(sizeof(struct frozenList));
+	if (frozen == NULL) return NULL;
+	frozen->length = list->length;
+	frozen->blockCount = (list->length + FROZEN_BLOCK_ITEMS - 1) / FROZEN_BLOCK_ITEMS;
+	frozen->blocks = NULL;
+	frozen->data = NULL;
+	frozen->dataLength = 0;
+	frozen->sorted = TRUE;
+	if (list->length == 0) return frozen;
+	frozen->blocks = (struct frozenBlock*)malloc(sizeof(struct frozenBlock) * frozen->blockCount);
+
+	// Start with 2 bytes per item, and grow the buffer when a block might not fit
+	size_t capacity = (size_t)list->length * 2 + 16;
+	frozen->data = (unsigned char*)malloc(capacity);
+	if (frozen->blocks == NULL || frozen->data == NULL)
+	{
+		destroy_frozen(&frozen);
+		return NULL;
+	}
+	int index = 0;
+	long long previous = 0;
+	struct frozenBlock* block = NULL;
+	SCAN_FORWARD(list, current,
+	{
+		long long value = (long long)current;
+		if (index % FROZEN_BLOCK_ITEMS == 0)
+		{
+			if (capacity - frozen->dataLength < FROZEN_BLOCK_ITEMS * 10)
+			{
+				capacity = capacity * 2 + FROZEN_BLOCK_ITEMS * 10;
+				unsigned char* larger = (unsigned char*)realloc(frozen->data, capacity);
+				if (larger == NULL)
+				{
+					destroy_frozen(&frozen);
+					return NULL;
+				}
+				frozen->data = larger;
+			}
+			block = frozen->blocks + index / FROZEN_BLOCK_ITEMS;
+			block->first = block->min = block->max = value;
+			block->offset = frozen->dataLength;
+		}
+		else
+		{
+			// Zigzag encoding of the difference, computed with wrapping arithmetic
+			unsigned long long delta = (unsigned long long)value - (unsigned long long)previous;
+			unsigned long long zigzag = (delta << 1) ^ (0ULL - (delta >> 63));
+			frozen->dataLength += writeVarint(frozen->data + frozen->dataLength, zigzag);
+			if (value < block->min) block->min = value;
+			if (value > block->max) block->max = value;
+		}
+		if (index > 0 && value < previous) frozen->sorted = FALSE;
+		previous = value;
+		index++;
+	});
+
+	// Release the unused part of the buffer
+	unsigned char* trimmed = (unsigned char*)realloc(frozen->data, frozen->dataLength + 1);
+	if (trimmed != NULL) frozen->data = trimmed;
+	return frozen;
+}
+
+// Thaw
+list_t thaw(frozen_list_t frozen)
+{
+	if (frozen == NULL) return NULL;
+	int length;
+	T* items = frozen_to_array(frozen, &length);
+	if (length == 0) return create();
+	return items == NULL ? NULL : create_adopting(items, length, free);
+}
+
+// DestroyFrozen
+bool_t destroy_frozen(frozen_list_t* frozen)
+{
+	if (frozen == NULL || *frozen == NULL) return FALSE;
+	free((*frozen)->blocks);
+	free((*frozen)->data);
+	free(*frozen);
+	*frozen = NULL;
+	return TRUE;
+}
+
+// FrozenSize
+int frozen_size(frozen_list_t frozen)
+{
+	return frozen == NULL ? -1 : frozen->length;
+}
+
+// FrozenBytes
+size_t frozen_bytes(frozen_list_t frozen)
+{
+	if (frozen == NULL) return 0;
+	return sizeof(struct frozenList) + frozen->dataLength
+		+ sizeof(struct frozenBlock) * frozen->blockCount;
+}
+
+// FrozenToArray
+T* frozen_to_array(frozen_list_t frozen, int* size)
+{
+	if (frozen == NULL)
+	{
+		*size = -1;
+		return NULL;
+	}
+	*size = frozen->length;
+	if (frozen->length == 0) return NULL;
+	T* items = (T*)malloc(sizeof(T) * frozen->length);
+	if (items == NULL) return NULL;
+	int i;
+	for (i = 0; i < frozen->blockCount; i++)
+	{
+		decodeBlock(frozen, i, items + i * FROZEN_BLOCK_ITEMS);
+	}
+	return items;
+}
+
+// FrozenIsElement
+bool_t frozen_is_element(const T item, frozen_list_t frozen)
+{
+	if (frozen == NULL) return FALSE;
+	long long value = (long long)item;
+	int start = 0, end = frozen->blockCount;
+	if (frozen->sorted)
+	{
+		// Only the first block with a maximum not lower than the item can contain it
+		while (start < end)
+		{
+			int middle = start + (end - start) / 2;
+			if (frozen->blocks[middle].max < value) start = middle + 1;
+			else end = middle;
+		}
+		end = start < frozen->blockCount ? start + 1 : start;
+	}
+	T items[FROZEN_BLOCK_ITEMS];
+	int i, j;
+	for (i = start; i < end; i++)
+	{
+		if (value < frozen->blocks[i].min || value > frozen->blocks[i].max) continue;
+		int count = decodeBlock(frozen, i, items);
+		for (j = 0; j < count; j++)
+		{
+			if (items[j] == item) return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// FrozenForEach
+bool_t frozen_for_each(frozen_list_t frozen, void(*expression)(item_arg_t))
+{
+	if (frozen == NULL || frozen->length == 0) return FALSE;
+	SCAN_FROZEN(frozen, current,
+	{
+		expression(SCANNED_ARG(current));
+	});
+	return TRUE;
+}
+
+// FrozenCount
+int frozen_count(frozen_list_t frozen, bool_t(*expression)(item_arg_t))
+{
+	if (frozen == NULL || frozen->length == 0) return -1;
+	int total = 0;
+	SCAN_FROZEN(frozen, current,
+	{
+		if (expression(SCANNED_ARG(current))) total++;
+	});
+	return total;
+}
+
+// FrozenSum
+int frozen_sum(frozen_list_t frozen, int(*expression)(item_arg_t))
+{
+	if (frozen == NULL || frozen->length == 0) return 0;
+	int total = 0;
+	SCAN_FROZEN(frozen, current,
+	{
+		total += expression(SCANNED_ARG(current));
+	});
+	return total;
+}
+
+#endif
+
+/* ================== Persistent lists ================== */
+
+// Height and size of a subtree, that can be NULL
+#define TREE_HEIGHT(node) ((node) == NULL ? 0 : (node)->height)
+#define TREE_SIZE(node) ((node) == NULL ? 0 : (node)->size)
+
+// Maximum height of a tree: an AVL tree with INT_MAX nodes is shorter than that
+#define MAX_TREE_HEIGHT 64
+
+// Adds a reference to a subtree and returns it
+static inline treePointer retainTree(treePointer node)
+{
+	if (node != NULL) __atomic_add_fetch(&node->references, 1, __ATOMIC_RELAXED);
+	return node;
+}
+
+// Releases a reference to a subtree, deallocating the nodes that aren't used anymore
+static void releaseTree(treePointer node)
+{
+	while (node != NULL && __atomic_sub_fetch(&node->references, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		treePointer right = node->right;
+		releaseTree(node->left);
+		free(node);
+		node = right;
+	}
+}
+
+// Creates a new node that takes the references to the given subtrees
+static treePointer makeNode(const T info, treePointer left, treePointer right)
+{
+	treePointer node = (treePointer)malloc(sizeof(struct persistentNode));
+	node->references = 1;
+	node->info = info;
+	node->left = left;
+	node->right = right;
+	int leftHeight = TREE_HEIGHT(left), rightHeight = TREE_HEIGHT(right);
+	node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+	node->size = TREE_SIZE(left) + TREE_SIZE(right) + 1;
+	return node;
+}
+
+// Creates a node with the given subtrees, rotating them if their heights
+// differ by 2. The rotated nodes are copied, as they could be shared
+static treePointer balanceNode(const T info, treePointer left, treePointer right)
+{
+	int difference = TREE_HEIGHT(left) - TREE_HEIGHT(right);
+	treePointer result;
+	if (difference > 1)
+	{
+		if (TREE_HEIGHT(left->left) >= TREE_HEIGHT(left->right))
+		{
+			result = makeNode(left->info, retainTree(left->left),
+				makeNode(info, retainTree(left->right), right));
+		}
+		else
+		{
+			treePointer middle = left->right;
+			result = makeNode(middle->info,
+				makeNode(left->info, retainTree(left->left), retainTree(middle->left)),
+				makeNode(info, retainTree(middle->right), right));
+		}
+		releaseTree(left);
+		return result;
+	}
+	if (difference < -1)
+	{
+		if (TREE_HEIGHT(right->right) >= TREE_HEIGHT(right->left))
+		{
+			result = makeNode(right->info,
+				makeNode(info, left, retainTree(right->left)), retainTree(right->right));
+		}
+		else
+		{
+			treePointer middle = right->left;
+			result = makeNode(middle->info,
+				makeNode(info, left, retainTree(middle->left)),
+				makeNode(right->info, retainTree(middle->right), retainTree(right->right)));
+		}
+		releaseTree(right);
+		return result;
+	}
+	return makeNode(info, left, right);
+}
+
+// Returns a copy of a subtree with an item inserted in the given position
+static treePointer insertNode(treePointer node, int index, const T item)
+{
+	if (node == NULL) return makeNode(item, NULL, NULL);
+	int leftSize = TREE_SIZE(node->left);
+	if (index <= leftSize)
+	{
+		return balanceNode(node->info, insertNode(node->left, index, item), retainTree(node->right));
+	}
+	return balanceNode(node->info, retainTree(node->left), insertNode(node->right, index - leftSize - 1, item));
+}
+
+// Returns a copy of a subtree with a different item in the given position
+static treePointer replaceNode(treePointer node, int index, const T item)
+{
+	int leftSize = TREE_SIZE(node->left);
+	if (index < leftSize)
+	{
+		return makeNode(node->info, replaceNode(node->left, index, item), retainTree(node->right));
+	}
+	if (index > leftSize)
+	{
+		return makeNode(node->info, retainTree(node->left), replaceNode(node->right, index - leftSize - 1, item));
+	}
+	return makeNode(item, retainTree(node->left), retainTree(node->right));
+}
+
+// Returns a copy of a subtree without its first item, that is assigned to first
+static treePointer removeFirstNode(treePointer node, T* first)
+{
+	if (node->left == NULL)
+	{
+		*first = node->info;
+		return retainTree(node->right);
+	}
+	return balanceNode(node->info, removeFirstNode(node->left, first), retainTree(node->right));
+}
+
+// Returns a copy of a subtree without the item in the given position
+static treePointer removeNode(treePointer node, int index)
+{
+	int leftSize = TREE_SIZE(node->left);
+	if (index < leftSize)
+	{
+		return balanceNode(node->info, removeNode(node->left, index), retainTree(node->right));
+	}
+	if (index > leftSize)
+	{
+		return balanceNode(node->info, retainTree(node->left), removeNode(node->right, index - leftSize - 1));
+	}
+	if (node->left == NULL) return retainTree(node->right);
+	if (node->right == NULL) return retainTree(node->left);
+
+	// Replace the node with the first item of its right subtree
+	T next;
+	treePointer right = removeFirstNode(node->right, &next);
+	return balanceNode(next, retainTree(node->left), right);
+}
+
+// Builds a perfectly balanced subtree with the given items
+static treePointer buildTree(const T* items, int count)
+{
+	if (count == 0) return NULL;
+	int middle = count / 2;
+	treePointer left = buildTree(items, middle);
+	return makeNode(items[middle], left, buildTree(items + middle + 1, count - middle - 1));
+}
+
+// Creates a new version that takes the reference to the given tree
+static persistent_list_t wrapTree(treePointer root)
+{
+	persistent_list_t persistent = (persistent_list_t)malloc(sizeof(struct persistentList));
+	persistent->root = root;
+	return persistent;
+}
+
+// Loops over the items of a tree in order, assigning each of them to item.
+// The loop body can use break, continue and return like in a standard loop
+#define SCAN_TREE(root, item, ...)                                \
+{                                                                 \
+	treePointer treeStack[MAX_TREE_HEIGHT];                       \
+	int treeDepth = 0;                                            \
+	treePointer treeNode = root;                                  \
+	while (treeNode != NULL || treeDepth > 0)                     \
+	{                                                             \
+		while (treeNode != NULL)                                  \
+		{                                                         \
+			treeStack[treeDepth++] = treeNode;                    \
+			treeNode = treeNode->left;                            \
+		}                                                         \
+		treeNode = treeStack[--treeDepth];                        \
+		SCAN_ITEM(item, treeNode->info);                          \
+		treeNode = treeNode->right;                               \
+		__VA_ARGS__                                               \
+	}                                                             \
+}
+
+// CreatePersistent
+persistent_list_t create_persistent()
+{
+	return wrapTree(NULL);
+}
+
+// ToPersistent
+persistent_list_t to_persistent(list_t list)
+{
+	READ_LOCK(list);
+	if (list == NULL) return NULL;
+	if (list->items != NULL) return wrapTree(buildTree(list->items, list->length));
+	int length;
+	T* items = to_array(list, &length);
+	persistent_list_t persistent = wrapTree(buildTree(items, length));
+	free(items);
+	return persistent;
+}
+
+// PersistentToList
+list_t persistent_to_list(persistent_list_t persistent)
+{
+	if (persistent == NULL) return NULL;
+	int length;
+	T* items = persistent_to_array(persistent, &length);
+	if (length == 0) return create();
+	return items == NULL ? NULL : create_adopting(items, length, free);
+}
+
+// DestroyPersistent
+bool_t destroy_persistent(persistent_list_t* persistent)
+{
+	if (persistent == NULL || *persistent == NULL) return FALSE;
+	releaseTree((*persistent)->root);
+	free(*persistent);
+	*persistent = NULL;
+	return TRUE;
+}
+
+// PersistentSize
+int persistent_size(persistent_list_t persistent)
+{
+	return persistent == NULL ? -1 : TREE_SIZE(persistent->root);
+}
+
+// PersistentGet
+bool_t persistent_get(persistent_list_t persistent, int index, T* result)
+{
+	if (persistent == NULL || index < 0 || index >= TREE_SIZE(persistent->root)) return FALSE;
+	treePointer node = persistent->root;
+	while (TRUE)
+	{
+		int leftSize = TREE_SIZE(node->left);
+		if (index == leftSize) break;
+		if (index < leftSize) node = node->left;
+		else
+		{
+			index -= leftSize + 1;
+			node = node->right;
+		}
+	}
+	*result = node->info;
+	return TRUE;
+}
+
+// PersistentAdd
+persistent_list_t persistent_add(const T item, persistent_list_t persistent)
+{
+	if (persistent == NULL) return NULL;
+	return wrapTree(insertNode(persistent->root, TREE_SIZE(persistent->root), item));
+}
+
+// PersistentAddAt
+persistent_list_t persistent_add_at(const T item, persistent_list_t persistent, int index)
+{
+	if (persistent == NULL || index < 0 || index > TREE_SIZE(persistent->root)) return NULL;
+	return wrapTree(insertNode(persistent->root, index, item));
+}
+
+// PersistentReplaceAt
+persistent_list_t persistent_replace_at(const T item, persistent_list_t persistent, int index)
+{
+	if (persistent == NULL || index < 0 || index >= TREE_SIZE(persistent->root)) return NULL;
+	return wrapTree(replaceNode(persistent->root, index, item));
+}
+
+// PersistentRemoveAt
+persistent_list_t persistent_remove_at(persistent_list_t persistent, int index)
+{
+	if (persistent == NULL || index < 0 || index >= TREE_SIZE(persistent->root)) return NULL;
+	return wrapTree(removeNode(persistent->root, index));
+}
+
+// PersistentToArray
+T* persistent_to_array(persistent_list_t persistent, int* size)
+{
+	if (persistent == NULL)
+	{
+		*size = -1;
+		return NULL;
+	}
+	*size = TREE_SIZE(persistent->root);
+	if (*size == 0) return NULL;
+	T* items = (T*)malloc(sizeof(T) * *size);
+	if (items == NULL) return NULL;
+	int index = 0;
+	SCAN_TREE(persistent->root, current,
+	{
+		items[index++] = SCANNED_ITEM(current);
+	});
+	return items;
+}
+
+// Returns the given value if a persistent list is NULL or empty
+#define RETURN_IF_EMPTY_TREE(persistent, value) \
+if (persistent == NULL || persistent->root == NULL) return value
+
+// PersistentIsElement
+bool_t persistent_is_element(const T item, persistent_list_t persistent)
+{
+	RETURN_IF_EMPTY_TREE(persistent, FALSE);
+	SCAN_TREE(persistent->root, current,
+	{
+		if (ITEMS_EQUAL(SCANNED_ITEM(current), item)) return TRUE;
+	});
+	return FALSE;
+}
+
+// PersistentIndexOf
+int persistent_index_of(const T item, persistent_list_t persistent)
+{
+	RETURN_IF_EMPTY_TREE(persistent, -1);
+	int index = 0;
+	SCAN_TREE(persistent->root, current,
+	{
+		if (ITEMS_EQUAL(SCANNED_ITEM(current), item)) return index;
+		index++;
+	});
+	return -1;
+}
+
+// PersistentForEach
+bool_t persistent_for_each(persistent_list_t persistent, void(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, FALSE);
+	SCAN_TREE(persistent->root, current,
+	{
+		expression(SCANNED_ARG(current));
+	});
+	return TRUE;
+}
+
+// PersistentFirstOrDefault
+bool_t persistent_first_or_default(persistent_list_t persistent, T* result, bool_t(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, FALSE);
+	SCAN_TREE(persistent->root, current,
+	{
+		if (expression(SCANNED_ARG(current)))
+		{
+			*result = SCANNED_ITEM(current);
+			return TRUE;
+		}
+	});
+	return FALSE;
+}
+
+// PersistentCount
+int persistent_count(persistent_list_t persistent, bool_t(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, -1);
+	int total = 0;
+	SCAN_TREE(persistent->root, current,
+	{
+		if (expression(SCANNED_ARG(current))) total++;
+	});
+	return total;
+}
+
+// PersistentAny
+bool_t persistent_any(persistent_list_t persistent, bool_t(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, FALSE);
+	SCAN_TREE(persistent->root, current,
+	{
+		if (expression(SCANNED_ARG(current))) return TRUE;
+	});
+	return FALSE;
+}
+
+// PersistentAll
+bool_t persistent_all(persistent_list_t persistent, bool_t(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, FALSE);
+	SCAN_TREE(persistent->root, current,
+	{
+		if (!expression(SCANNED_ARG(current))) return FALSE;
+	});
+	return TRUE;
+}
+
+// PersistentWhere
+list_t persistent_where(persistent_list_t persistent, bool_t(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, NULL);
+	list_t outList = create();
+	SCAN_TREE(persistent->root, current,
+	{
+		if (expression(SCANNED_ARG(current))) add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
+}
+
+// PersistentSum
+int persistent_sum(persistent_list_t persistent, int(*expression)(item_arg_t))
+{
+	RETURN_IF_EMPTY_TREE(persistent, 0);
+	int total = 0;
+	SCAN_TREE(persistent->root, current,
+	{
+		total += expression(SCANNED_ARG(current));
+	});
+	return total;
+}
+
+/* ============================================================================
+*  stack_t
+*  ========================================================================= */
+
+/* ================== Array stack ================== */
+
+// Minimum number of items allocated by an array stack_t
+#define MIN_STACK_ITEMS 16
+
+// Moves the items of an array stack_t at the end of a new buffer with
+// room for at least the given number of items, and at least twice as
+// many as the previous one
+static bool_t growStack(stack_t stack, int capacity)
+{
+	int reserved = stack->reserved * 2;
+	if (reserved < MIN_STACK_ITEMS) reserved = MIN_STACK_ITEMS;
+	if (reserved < capacity) reserved = capacity;
+	T* buffer = (T*)malloc(sizeof(T) * reserved);
+	if (buffer == NULL) return FALSE;
+	T* items = buffer + reserved - stack->length;
+	if (stack->length > 0) memcpy(items, stack->items, sizeof(T) * stack->length);
+	free(stack->buffer);
+	stack->buffer = buffer;
+	stack->reserved = reserved;
+	stack->items = items;
+	return TRUE;
+}
+
+// Checks if a stack_t is an array stack_t that still uses its contiguous storage
+#define USES_ARRAY(stack) ((stack)->arrayStack && ((stack)->items != NULL || (stack)->length == 0))
+
+// CreateArrayStack
+stack_t create_array_stack(int capacity)
+{
+	if (capacity < 0) return NULL;
+	stack_t outStack = create();
+	outStack->arrayStack = TRUE;
+	if (capacity > 0 && !growStack(outStack, capacity))
+	{
+		free(outStack);
+		return NULL;
+	}
+	return outStack;
+}
+
+// Reserve
+bool_t reserve(stack_t stack, int capacity)
+{
+	WRITE_LOCK(stack, FALSE);
+	if (stack == NULL || capacity < 0 || !USES_ARRAY(stack)) return FALSE;
+	if (stack->buffer != NULL && stack->reserved >= capacity) return TRUE;
+	return growStack(stack, capacity < stack->length ? stack->length : capacity);
+}
+
+/* ================== Lock-free stack ================== */
+
+// Returns the node with the given index in the pool of a lock-free stack_t
+static inline struct stackNode* stackNodeAt(struct lockFreeStack* stack, uint32_t index)
+{
+	uint32_t position = index - 1;
+	int block = 31 - __builtin_clz(position / STACK_BLOCK_NODES + 1);
+	struct stackNode* nodes = __atomic_load_n(&stack->blocks[block], __ATOMIC_ACQUIRE);
+	return nodes + position - STACK_BLOCK_NODES * ((1u << block) - 1);
+}
+
+#define NEXT_NODE(stack, index) __atomic_load_n(&stackNodeAt(stack, index)->next, __ATOMIC_RELAXED)
+#define SET_NEXT_NODE(stack, index, value) __atomic_store_n(&stackNodeAt(stack, index)->next, value, __ATOMIC_RELAXED)
+
+// Copies the item of a node that another thread can be using: with an atomic
+// access when T fits in one, otherwise with a plain copy that can be torn,
+// as the copies read from a node that changed are discarded anyway
+#define COPY_NODE_ITEM(atomic, target, source) __builtin_choose_expr(    \
+	sizeof(T) <= sizeof(uint64_t) && __alignof__(T) == sizeof(T),        \
+	atomic, (void)memcpy(target, source, sizeof(T)))
+#define LOAD_NODE_ITEM(node, target) COPY_NODE_ITEM(                     \
+	__atomic_load(&(node)->info, target, __ATOMIC_RELAXED), target, &(node)->info)
+#define STORE_NODE_ITEM(node, source) COPY_NODE_ITEM(                    \
+	__atomic_store(&(node)->info, source, __ATOMIC_RELAXED), &(node)->info, source)
+
+// Moves all the nodes of a thread cache to the shared chain of the free nodes
+static void flushNodeCache(void* target)
+{
+	struct nodeCache* cache = (struct nodeCache*)target;
+	if (cache->head == 0) return;
+	struct lockFreeStack* stack = cache->stack;
+	uint32_t first = __atomic_load_n(&stack->free, __ATOMIC_RELAXED);
+	do
+	{
+		SET_NEXT_NODE(stack, cache->tail, first);
+	} while (!__atomic_compare_exchange_n(&stack->free, &first, cache->head,
+		TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	cache->head = 0;
+	cache->tail = 0;
+	cache->count = 0;
+}
+
+// Returns the node cache of the current thread, creating it if needed
+static struct nodeCache* getNodeCache(struct lockFreeStack* stack)
+{
+	struct nodeCache* cache = (struct nodeCache*)pthread_getspecific(stack->cacheKey);
+	if (cache != NULL) return cache;
+	cache = (struct nodeCache*)malloc(sizeof(struct nodeCache));
+	if (cache == NULL) return NULL;
+	cache->stack = stack;
+	cache->head = 0;
+	cache->tail = 0;
+	cache->count = 0;
+	cache->next = __atomic_load_n(&stack->caches, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&stack->caches, &cache->next, cache,
+		TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	pthread_setspecific(stack->cacheKey, cache);
+	return cache;
+}
+
+// Takes a free node from the cache of the current thread, from the nodes
+// released by the other threads or from the pool, returns 0 if it's full
+static uint32_t takeStackNode(struct lockFreeStack* stack)
+{
+	struct nodeCache* cache = getNodeCache(stack);
+	if (cache != NULL && cache->head == 0)
+	{
+		// Take all the nodes released by the other threads at once
+		uint32_t chain = __atomic_exchange_n(&stack->free, 0, __ATOMIC_ACQUIRE);
+		if (chain != 0)
+		{
+			cache->head = chain;
+			cache->count = 1;
+			while (NEXT_NODE(stack, chain) != 0)
+			{
+				chain = NEXT_NODE(stack, chain);
+				cache->count++;
+			}
+			cache->tail = chain;
+		}
+	}
+	if (cache != NULL && cache->head != 0)
+	{
+		uint32_t index = cache->head;
+		cache->head = NEXT_NODE(stack, index);
+		if (cache->head == 0) cache->tail = 0;
+		cache->count--;
+		return index;
+	}
+
+	// Use a new node, allocating its block if no other thread did that already
+	uint32_t position = __atomic_fetch_add(&stack->allocated, 1, __ATOMIC_RELAXED);
+	if (position >= STACK_BLOCK_NODES * ((1u << STACK_POOL_BLOCKS) - 1)) return 0;
+	int block = 31 - __builtin_clz(position / STACK_BLOCK_NODES + 1);
+	if (__atomic_load_n(&stack->blocks[block], __ATOMIC_ACQUIRE) == NULL)
+	{
+		struct stackNode* nodes = (struct stackNode*)malloc(
+			sizeof(struct stackNode) * ((size_t)STACK_BLOCK_NODES << block));
+		if (nodes == NULL) return 0;
+		struct stackNode* expected = NULL;
+		if (!__atomic_compare_exchange_n(&stack->blocks[block], &expected, nodes,
+			FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) free(nodes);
+	}
+	return position + 1;
+}
+
+// Releases a popped node to the cache of the current thread, moving the
+// cached nodes to the shared chain when there are too many of them
+static void releaseStackNode(struct lockFreeStack* stack, uint32_t index)
+{
+	struct nodeCache* cache = getNodeCache(stack);
+	struct nodeCache single = { stack, NULL, 0, 0, 0 };
+	if (cache == NULL) cache = &single;
+	SET_NEXT_NODE(stack, index, cache->head);
+	cache->head = index;
+	if (cache->tail == 0) cache->tail = index;
+	if (++cache->count > STACK_BLOCK_NODES || cache == &single) flushNodeCache(cache);
+}
+
+// Builds the value of the top of a lock-free stack_t, with the next tag
+#define NEXT_TOP(index, top) ((((top) >> 32) + 1) << 32 | (uint64_t)(index))
+
+// Pushes an item on a lock-free stack_t
+static bool_t lockFreePush(struct lockFreeStack* stack, const T item)
+{
+	uint32_t index = takeStackNode(stack);
+	if (index == 0) return FALSE;
+	struct stackNode* node = stackNodeAt(stack, index);
+	STORE_NODE_ITEM(node, (T*)&item);
+	uint64_t top = __atomic_load_n(&stack->top, __ATOMIC_RELAXED);
+	do
+	{
+		__atomic_store_n(&node->next, (uint32_t)top, __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(&stack->top, &top, NEXT_TOP(index, top),
+		TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	return TRUE;
+}
+
+// Pops an item from a lock-free stack_t
+static bool_t lockFreePop(struct lockFreeStack* stack, T* result)
+{
+	uint64_t top = __atomic_load_n(&stack->top, __ATOMIC_ACQUIRE);
+	uint32_t index, next;
+	do
+	{
+		index = (uint32_t)top;
+		if (index == 0) return FALSE;
+
+		// The node could be popped by another thread in the meantime: in
+		// that case the tag is different and the exchange fails
+		next = NEXT_NODE(stack, index);
+	} while (!__atomic_compare_exchange_n(&stack->top, &top, NEXT_TOP(next, top),
+		TRUE, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+	LOAD_NODE_ITEM(stackNodeAt(stack, index), result);
+	releaseStackNode(stack, index);
+	return TRUE;
+}
+
+// Reads the top item of a lock-free stack_t, checking that the top
+// node didn't change while its value was being read
+static bool_t lockFreePeek(struct lockFreeStack* stack, T* result)
+{
+	uint64_t top = __atomic_load_n(&stack->top, __ATOMIC_ACQUIRE);
+	while ((uint32_t)top != 0)
+	{
+		T item;
+		LOAD_NODE_ITEM(stackNodeAt(stack, (uint32_t)top), &item);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		uint64_t check = __atomic_load_n(&stack->top, __ATOMIC_ACQUIRE);
+		if (check == top)
+		{
+			*result = item;
+			return TRUE;
+		}
+		top = check;
+	}
+	return FALSE;
+}
+
+// Releases the storage of a lock-free stack_t, if the list_t has one
+static void releaseLockFree(list_t list)
+{
+	struct lockFreeStack* stack = list->lockFree;
+	if (stack == NULL) return;
+	pthread_key_delete(stack->cacheKey);
+	while (stack->caches != NULL)
+	{
+		struct nodeCache* temp = stack->caches;
+		stack->caches = temp->next;
+		free(temp);
+	}
+	int i;
+	for (i = 0; i < STACK_POOL_BLOCKS; i++) free(stack->blocks[i]);
+	free(stack);
+	list->lockFree = NULL;
+}
+
+// CreateLockFreeStack
+stack_t create_lock_free_stack()
+{
+	struct lockFreeStack* stack = (struct lockFreeStack*)calloc(1, sizeof(struct lockFreeStack));
+	if (stack == NULL) return NULL;
+	if (pthread_key_create(&stack->cacheKey, flushNodeCache) != 0)
+	{
+		free(stack);
+		return NULL;
+	}
+	stack_t outStack = create();
+	outStack->readonly = TRUE;
+	outStack->lockFree = stack;
+	return outStack;
+}
+
+// Push
+bool_t push(const T item, stack_t stack)
+{
+	if (stack != NULL && stack->lockFree != NULL) return lockFreePush(stack->lockFree, item);
+	WRITE_LOCK(stack, FALSE);
+	if (stack == NULL) return FALSE;
+	if (USES_ARRAY(stack))
+	{
+		if ((stack->buffer == NULL || stack->items == stack->buffer)
+			&& !growStack(stack, stack->length + 1)) return FALSE;
+		*--stack->items = item;
+		stack->length++;
+		stack->sync++;
+		return TRUE;
+	}
+	if (stack->length == 0)
+	{
+		return add(item, stack);
+	}
+	ENSURE_NODES(stack, FALSE);
+	nodePointer newNode = allocateNode(stack);
+	newNode->info = item;
+	newNode->previous = NULL;
+	stack->head->previous = newNode;
+	newNode->next = stack->head;
+	stack->head = newNode;
+	stack->length++;
+	indexNodes(stack, newNode, 1);
+	filterNodes(stack, newNode, 1);
+	stack->sync++;
+	return TRUE;
+}
+
+// Pop
+bool_t pop(stack_t stack, T* result)
+{
+	if (stack != NULL && stack->lockFree != NULL) return lockFreePop(stack->lockFree, result);
+	WRITE_LOCK(stack, FALSE);
+	RETURN_IF_EMPTY(stack, FALSE);
+	if (USES_ARRAY(stack))
+	{
+		*result = *stack->items++;
+		stack->length--;
+		stack->sync++;
+		return TRUE;
+	}
+	ENSURE_NODES(stack, FALSE);
+	*result = stack->head->info;
+	if (stack->length == 1)
+	{
+		releaseNode(stack, stack->head);
+		stack->head = NULL;
+		stack->tail = NULL;
+	}
+	else
+	{
+		nodePointer temp = stack->head;
+		stack->head = temp->next;
+		stack->head->previous = NULL;
+		releaseNode(stack, temp);
+	}
+	stack->length--;
+	stack->sync++;
+	return TRUE;
+}
+
+// Peek
+bool_t peek(stack_t stack, T* result)
+{
+	if (stack != NULL && stack->lockFree != NULL) return lockFreePeek(stack->lockFree, result);
+	READ_LOCK(stack);
+	return GetFirst(stack, result);
+}
+
+/* ============================================================================
+*  queue_t
+*  ========================================================================= */
+
+// Maximum capacity of a queue_t
+#define MAX_QUEUE_CAPACITY (1 << 30)
+
+// Creates a queue_t with a capacity rounded up to the next power of 2
+static queue_t createRing(int capacity, bool_t single)
+{
+	if (capacity <= 0 || capacity > MAX_QUEUE_CAPACITY) return NULL;
+	size_t length = 2;
+	while (length < (size_t)capacity) length <<= 1;
+	queue_t queue = (queue_t)calloc(1, sizeof(struct ringQueue));
+	if (queue == NULL) return NULL;
+	queue->mask = length - 1;
+	queue->single = single;
+	if (single) queue->items = (T*)malloc(sizeof(T) * length);
+	else
+	{
+		queue->cells = (struct queueCell*)malloc(sizeof(struct queueCell) * length);
+		if (queue->cells != NULL)
+		{
+			size_t i;
+			for (i = 0; i < length; i++) queue->cells[i].sequence = i;
+		}
+	}
+	if (queue->items == NULL && queue->cells == NULL)
+	{
+		free(queue);
+		return NULL;
+	}
+	return queue;
+}
+
+// CreateQueue
+queue_t create_queue(int capacity)
+{
+	return createRing(capacity, FALSE);
+}
+
+// CreateSPSCQueue
+queue_t create_spsc_queue(int capacity)
+{
+	return createRing(capacity, TRUE);
+}
+
+// DestroyQueue
+bool_t destroy_queue(queue_t* queue)
+{
+	if (queue == NULL || *queue == NULL) return FALSE;
+	free((*queue)->cells);
+	free((*queue)->items);
+	free(*queue);
+	*queue = NULL;
+	return TRUE;
+}
+
+// QueueSize
+int queue_size(queue_t queue)
+{
+	if (queue == NULL) return -1;
+	size_t dequeued = __atomic_load_n(&queue->dequeuePosition, __ATOMIC_ACQUIRE);
+	size_t enqueued = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_ACQUIRE);
+	ptrdiff_t count = (ptrdiff_t)(enqueued - dequeued);
+	if (count < 0) return 0;
+	return count > (ptrdiff_t)queue->mask + 1 ? (int)queue->mask + 1 : (int)count;
+}
+
+// Reserves up to count consecutive positions of a queue_t used by many
+// threads, to enqueue (offset 0) or to dequeue (offset 1) their items.
+// A cell is ready when its sequence is equal to its position + offset:
+// the positions are only reserved if they are all ready and no other
+// thread reserved them in the meantime. Returns the number of positions
+// reserved, starting from the one assigned to first
+static int reserveCells(queue_t queue, size_t* target, size_t offset, int count, size_t* first)
+{
+	size_t position = __atomic_load_n(target, __ATOMIC_RELAXED);
+	while (TRUE)
+	{
+		int ready = 0;
+		while (ready < count)
+		{
+			struct queueCell* cell = queue->cells + ((position + ready) & queue->mask);
+			size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+			if (sequence != position + ready + offset) break;
+			ready++;
+		}
+		if (ready == 0)
+		{
+			// Check if the queue is full or empty, or if another thread was faster
+			struct queueCell* cell = queue->cells + (position & queue->mask);
+			ptrdiff_t difference = (ptrdiff_t)(__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - (position + offset));
+			if (difference < 0) return 0;
+			position = __atomic_load_n(target, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (__atomic_compare_exchange_n(target, &position, position + ready,
+			TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+			*first = position;
+			return ready;
+		}
+	}
+}
+
+// Adds the items to a queue_t used by a single producer, up to its capacity
+static int enqueueSingle(queue_t queue, const T* array, int count)
+{
+	size_t position = queue->enqueuePosition;
+	size_t room = queue->mask + 1 - (position - queue->seenDequeuePosition);
+	if (room < (size_t)count)
+	{
+		queue->seenDequeuePosition = __atomic_load_n(&queue->dequeuePosition, __ATOMIC_ACQUIRE);
+		room = queue->mask + 1 - (position - queue->seenDequeuePosition);
+		if ((size_t)count > room) count = (int)room;
+	}
+	int i;
+	for (i = 0; i < count; i++) queue->items[(position + i) & queue->mask] = array[i];
+	__atomic_store_n(&queue->enqueuePosition, position + count, __ATOMIC_RELEASE);
+	return count;
+}
+
+// Removes the items from a queue_t used by a single consumer, up to capacity
+static int dequeueSingle(queue_t queue, T* buffer, int capacity)
+{
+	size_t position = queue->dequeuePosition;
+	size_t available = queue->seenEnqueuePosition - position;
+	if (available < (size_t)capacity)
+	{
+		queue->seenEnqueuePosition = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_ACQUIRE);
+		available = queue->seenEnqueuePosition - position;
+		if ((size_t)capacity > available) capacity = (int)available;
+	}
+	int i;
+	for (i = 0; i < capacity; i++) buffer[i] = queue->items[(position + i) & queue->mask];
+	__atomic_store_n(&queue->dequeuePosition, position + capacity, __ATOMIC_RELEASE);
+	return capacity;
+}
+
+// EnqueueRange
+int enqueue_range(const T* array, int size, queue_t queue)
+{
+	if (queue == NULL || array == NULL || size < 0) return -1;
+	if (size == 0) return 0;
+	if (queue->single) return enqueueSingle(queue, array, size);
+	size_t first;
+	int count = reserveCells(queue, &queue->enqueuePosition, 0, size, &first), i;
+	for (i = 0; i < count; i++)
+	{
+		struct queueCell* cell = queue->cells + ((first + i) & queue->mask);
+		cell->info = array[i];
+		__atomic_store_n(&cell->sequence, first + i + 1, __ATOMIC_RELEASE);
+	}
+	return count;
+}
+
+// DequeueRange
+int dequeue_range(queue_t queue, T* buffer, int capacity)
+{
+	if (queue == NULL || buffer == NULL || capacity < 0) return -1;
+	if (capacity == 0) return 0;
+	if (queue->single) return dequeueSingle(queue, buffer, capacity);
+	size_t first;
+	int count = reserveCells(queue, &queue->dequeuePosition, 1, capacity, &first), i;
+	for (i = 0; i < count; i++)
+	{
+		struct queueCell* cell = queue->cells + ((first + i) & queue->mask);
+		buffer[i] = cell->info;
+		__atomic_store_n(&cell->sequence, first + i + queue->mask + 1, __ATOMIC_RELEASE);
+	}
+	return count;
+}
+
+// Enqueue
+bool_t enqueue(const T item, queue_t queue)
+{
+	return enqueue_range(&item, 1, queue) == 1;
+}
+
+// TryDequeue
+bool_t try_dequeue(queue_t queue, T* result)
+{
+	return dequeue_range(queue, result, 1) == 1;
+}
+
+// Dequeue
+bool_t dequeue(queue_t queue, T* result)
+{
+	if (queue == NULL) return FALSE;
+	while (!try_dequeue(queue, result))
+	{
+#ifdef _WIN32
+		SwitchToThread();
+#else
+		sched_yield();
+#endif
+	}
+	return TRUE;
+}
+
+/* ============================================================================
+*  append_list_t
+*  ========================================================================= */
+
+// CreateAppendList
+append_list_t create_append_list()
+{
+	return (append_list_t)calloc(1, sizeof(struct appendList));
+}
+
+// DestroyAppendList
+bool_t destroy_append_list(append_list_t* list)
+{
+	if (list == NULL || *list == NULL) return FALSE;
+	int i;
+	for (i = 0; i < APPEND_CHUNKS; i++) free((*list)->chunks[i]);
+	free(*list);
+	*list = NULL;
+	return TRUE;
+}
+
+// Returns a chunk of an append_list_t, allocating it if no other thread did it
+static T* appendChunk(append_list_t list, int chunk)
+{
+	T* items = __atomic_load_n(&list->chunks[chunk], __ATOMIC_ACQUIRE);
+	if (items != NULL) return items;
+	T* allocated = (T*)malloc(sizeof(T) * ((size_t)APPEND_CHUNK_ITEMS << chunk));
+	if (allocated == NULL) return NULL;
+	if (__atomic_compare_exchange_n(&list->chunks[chunk], &items, allocated,
+		FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return allocated;
+	free(allocated);
+	return items;
+}
+
+// AppendRange
+int append_range(const T* array, int size, append_list_t list)
+{
+	if (list == NULL || array == NULL || size < 0) return -1;
+	if (size == 0) return 0;
+	size_t position = __atomic_fetch_add(&list->reserved, (size_t)size, __ATOMIC_RELAXED);
+	if (position + size > INT_MAX)
+	{
+		__atomic_store_n(&list->failed, TRUE, __ATOMIC_RELAXED);
+		return -1;
+	}
+	int added = 0;
+	while (added < size)
+	{
+		// Copy the items that fit in the chunk of the current position
+		size_t index = position + added;
+		int chunk = 31 - __builtin_clz((unsigned int)(index / APPEND_CHUNK_ITEMS + 1));
+		size_t offset = index - (size_t)APPEND_CHUNK_ITEMS * ((1u << chunk) - 1);
+		size_t room = ((size_t)APPEND_CHUNK_ITEMS << chunk) - offset;
+		int count = (size_t)(size - added) < room ? size - added : (int)room;
+		T* items = appendChunk(list, chunk);
+		if (items == NULL)
 		{
-			clear(list);
-			return 1;
+			__atomic_store_n(&list->failed, TRUE, __ATOMIC_RELAXED);
+			return -1;
 		}
-		else return -1;
+		memcpy(items + offset, array + added, sizeof(T) * count);
+		added += count;
 	}
-	GET_HEAD_ITERATOR;
-	int total = 0;
-	while (iterator != NULL)
+	return size;
+}
+
+// Append
+bool_t append(const T item, append_list_t list)
+{
+	return append_range(&item, 1, list) == 1;
+}
+
+// Seal
+list_t seal(append_list_t* list)
+{
+	if (list == NULL || *list == NULL || (*list)->failed) return NULL;
+	int length = (int)(*list)->reserved, copied = 0, chunk;
+	list_t outList;
+	if (length == 0) outList = create();
+	else
 	{
-		if (iterator->info == item)
+		T* items = (T*)malloc(sizeof(T) * length);
+		if (items == NULL) return NULL;
+		for (chunk = 0; copied < length; chunk++)
 		{
-			// Last element inside the list_t
-			if (list->length == 1)
-			{
-				clear(list);
-				return total + 1;
-			}
+			size_t count = (size_t)APPEND_CHUNK_ITEMS << chunk;
+			if (count > (size_t)(length - copied)) count = length - copied;
+			memcpy(items + copied, (*list)->chunks[chunk], sizeof(T) * count);
+			copied += count;
+		}
+		outList = create_adopting(items, length, free);
+		if (outList == NULL) free(items);
+	}
+	if (outList != NULL) destroy_append_list(list);
+	return outList;
+}
 
-			// Item in last position
-			if (iterator->next == NULL)
-			{
-				// Set previous item as the last one
-				iterator->previous->next = NULL;
-				list->tail = iterator->previous;
-				list->length--;
-				free(iterator);
-				SYNC_PLUS;
-				return total + 1;
-			}
+/* ============================================================================
+*  rcu_list_t
+*  ========================================================================= */
 
-			// First element inside the list_t
-			if (iterator->previous == NULL)
-			{
-				list->head = iterator->next;
-				iterator->next->previous = NULL;			
-			}
-			else 
-			{
-				// Element in a random position
-				iterator->previous->next = iterator->next;
-				iterator->next->previous = iterator->previous;		
-			}		
-			list->length--;
-			nodePointer temp = iterator;
-			MOVE_NEXT;
-			free(temp);
-			total++;
-			SYNC_PLUS;
+// Returns a read-only version of an rcu_list_t with the items of a list_t,
+// stored in a single array, or NULL if there wasn't enough memory
+static list_t createVersion(list_t list)
+{
+	list_t version;
+	int length;
+	T* items = to_array(list, &length);
+	if (items == NULL) version = length == 0 ? create() : NULL;
+	else
+	{
+		version = create_adopting(items, length, free);
+		if (version == NULL) free(items);
+	}
+	if (version != NULL) version->readonly = TRUE;
+	return version;
+}
+
+// Marks the reader of a thread that ended as free
+static void releaseRCUReader(void* target)
+{
+	struct rcuReader* reader = (struct rcuReader*)target;
+	__atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&reader->used, FALSE, __ATOMIC_RELEASE);
+}
+
+// Returns the reader of the current thread, taking a free one or creating it if needed
+static struct rcuReader* getRCUReader(rcu_list_t list)
+{
+	struct rcuReader* reader = (struct rcuReader*)pthread_getspecific(list->readerKey);
+	if (reader != NULL) return reader;
+	for (reader = __atomic_load_n(&list->readers, __ATOMIC_ACQUIRE); reader != NULL; reader = reader->next)
+	{
+		bool_t used = FALSE;
+		if (__atomic_compare_exchange_n(&reader->used, &used, TRUE,
+			FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) break;
+	}
+	if (reader == NULL)
+	{
+		reader = (struct rcuReader*)calloc(1, sizeof(struct rcuReader));
+		if (reader == NULL) return NULL;
+		reader->used = TRUE;
+		reader->next = __atomic_load_n(&list->readers, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&list->readers, &reader->next, reader,
+			TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	}
+	reader->depth = 0;
+	pthread_setspecific(list->readerKey, reader);
+	return reader;
+}
+
+// Deallocates the old versions of an rcu_list_t that no reader can be using:
+// the ones replaced before the epoch of the oldest reader
+static void reclaimVersions(rcu_list_t list)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	size_t oldest = SIZE_MAX;
+	struct rcuReader* reader;
+	for (reader = __atomic_load_n(&list->readers, __ATOMIC_ACQUIRE); reader != NULL; reader = reader->next)
+	{
+		size_t epoch = __atomic_load_n(&reader->epoch, __ATOMIC_ACQUIRE);
+		if (epoch != 0 && epoch < oldest) oldest = epoch;
+	}
+	struct retiredVersion** pointer = &list->retired;
+	while (*pointer != NULL)
+	{
+		struct retiredVersion* retired = *pointer;
+		if (retired->epoch < oldest)
+		{
+			*pointer = retired->next;
+			destroy(&retired->version);
+			free(retired);
 		}
-		else MOVE_NEXT;
+		else pointer = &retired->next;
+	}
+}
+
+// CreateRCUList
+rcu_list_t create_rcu_list(list_t list)
+{
+	rcu_list_t outList = (rcu_list_t)calloc(1, sizeof(struct rcuList));
+	if (outList == NULL) return NULL;
+	outList->current = list == NULL ? create() : createVersion(list);
+	if (outList->current == NULL || pthread_key_create(&outList->readerKey, releaseRCUReader) != 0)
+	{
+		if (outList->current != NULL) destroy(&outList->current);
+		free(outList);
+		return NULL;
+	}
+	outList->current->readonly = TRUE;
+	outList->epoch = 1;
+	pthread_mutex_init(&outList->writer, NULL);
+	return outList;
+}
+
+// DestroyRCUList
+bool_t destroy_rcu_list(rcu_list_t* list)
+{
+	if (list == NULL || *list == NULL) return FALSE;
+	rcu_list_t target = *list;
+	pthread_key_delete(target->readerKey);
+	while (target->readers != NULL)
+	{
+		struct rcuReader* temp = target->readers;
+		target->readers = temp->next;
+		free(temp);
+	}
+	reclaimVersions(target);
+	destroy(&target->current);
+	pthread_mutex_destroy(&target->writer);
+	free(target);
+	*list = NULL;
+	return TRUE;
+}
+
+// BeginRCURead
+list_t begin_rcu_read(rcu_list_t list)
+{
+	if (list == NULL) return NULL;
+	struct rcuReader* reader = getRCUReader(list);
+	if (reader == NULL) return NULL;
+
+	// The epoch must be visible to the writers before the version is read
+	if (reader->depth++ == 0)
+	{
+		__atomic_store_n(&reader->epoch, __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST), __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+	return __atomic_load_n(&list->current, __ATOMIC_ACQUIRE);
+}
+
+// EndRCURead
+void end_rcu_read(rcu_list_t list)
+{
+	if (list == NULL) return;
+	struct rcuReader* reader = (struct rcuReader*)pthread_getspecific(list->readerKey);
+	if (reader == NULL || reader->depth == 0) return;
+	if (--reader->depth == 0) __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+// UpdateRCUList
+bool_t update_rcu_list(rcu_list_t list, bool_t(*update)(list_t))
+{
+	if (list == NULL || update == NULL) return FALSE;
+	pthread_mutex_lock(&list->writer);
+	list_t draft = copy(list->current), version = NULL;
+	struct retiredVersion* retired = (struct retiredVersion*)malloc(sizeof(struct retiredVersion));
+	if (draft != NULL && retired != NULL && update(draft)) version = createVersion(draft);
+	if (draft != NULL) destroy(&draft);
+	if (version == NULL)
+	{
+		free(retired);
+		pthread_mutex_unlock(&list->writer);
+		return FALSE;
+	}
+
+	// Publish the new version, then close the epoch the old one was replaced in
+	retired->version = __atomic_exchange_n(&list->current, version, __ATOMIC_SEQ_CST);
+	retired->epoch = __atomic_fetch_add(&list->epoch, 1, __ATOMIC_SEQ_CST);
+	retired->next = list->retired;
+	list->retired = retired;
+	reclaimVersions(list);
+	pthread_mutex_unlock(&list->writer);
+	return TRUE;
+}
+
+/* ============================================================================
+*  LINQ
+*  ========================================================================= */
+
+// FirstOrDefault
+bool_t first_or_default(list_t list, T* result, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	SCAN_FORWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current)))
+		{
+			*result = SCANNED_ITEM(current);
+			return TRUE;
+		}
+	});
+	return FALSE;
+}
+
+// LastOrDefault
+bool_t last_or_default(list_t list, T* result, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	SCAN_BACKWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current)))
+		{
+			*result = SCANNED_ITEM(current);
+			return TRUE;
+		}
+	});
+	return FALSE;
+}
+
+// Count
+int count(list_t list, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, -1);
+	int total = 0;
+	SCAN_FORWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current))) total++;
+	});
+	return total;
+}
+
+// FirstIndexWhere
+int first_index_where(list_t list, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, -1);
+	int position = 0;
+	SCAN_FORWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current))) return position;
+		position++;
+	});
+	return -1;
+}
+
+// LastIndexWhere
+int last_index_where(list_t list, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, -1);
+	int position = list->length - 1;
+	SCAN_BACKWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current))) return position;
+		position--;
+	});
+	return -1;
+}
+
+// Where
+list_t where(list_t list, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	list_t outList = create();
+	SCAN_FORWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current))) add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
+}
+
+// TakeWhile
+list_t take_while(list_t list, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	list_t outList = create();
+	int count = 0;
+	SCAN_FORWARD(list, current,
+	{
+		if (expression(SCANNED_ARG(current))) count++;
+		else break;
+	});
+	appendRange(outList, list, 0, count);
+	return outList;
+}
+
+// TakeRange
+list_t take_range(list_t list, int start, int end)
+{
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	if (start < 0 || end < 0 || start >= list->length
+		|| end >= list->length || start >= end) return NULL;
+	list_t outList = create();
+	appendRange(outList, list, start, end + 1 - start);
+	return outList;
+}
+
+// Concat
+list_t concat(list_t list1, list_t list2)
+{
+	READ_LOCK_PAIR;
+	if (list1 == NULL || list2 == NULL) return NULL;
+	if (list1->length == 0) return copy(list2);
+	list_t outList = copy(list1);
+	add_all(outList, list2);
+	return outList;
+}
+
+// Returns a pointer to the item of a list_t in the given position, moving the node
+// used to walk the list_t forward (it is ignored when using a contiguous storage)
+static inline const T* itemAt(list_t list, nodePointer* node, int index)
+{
+	if (list->items != NULL) return list->items + index;
+	const T* item = &(*node)->info;
+	if (index != list->length - 1) *node = (*node)->next;
+	return item;
+}
+
+#define GET_COUPLE_ITERATORS                                   \
+nodePointer iterator1 = list1->head, iterator2 = list2->head
+
+// Zip
+list_t zip(list_t list1, list_t list2, T(*expression)(item_arg_t, item_arg_t))
+{
+	READ_LOCK_PAIR;
+	if (CHECK_EMPTY(list1) || CHECK_EMPTY(list2)) return NULL;
+	GET_COUPLE_ITERATORS;
+	list_t outList = create();
+	int i, length = list1->length < list2->length ? list1->length : list2->length;
+	for (i = 0; i < length; i++)
+	{
+		const T* item1 = itemAt(list1, &iterator1, i);
+		add(expression(ITEM_ARG(*item1), ITEM_ARG(*itemAt(list2, &iterator2, i))), outList);
 	}
-	return total == 0 ? -1 : total;
+	return outList;
 }
 
-// ReplaceItem
-bool_t replace_item(const T target, const T replacement, list_t list)
+// Any
+bool_t any(list_t list, bool_t(*expression)(item_arg_t))
 {
+	READ_LOCK(list);
 	RETURN_IF_EMPTY(list, FALSE);
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	SCAN_FORWARD(list, current,
 	{
-		if (iterator->info == target)
-		{
-			iterator->info = replacement;
-			SYNC_PLUS;
-			return TRUE;
-		}
-		MOVE_NEXT;
-	}
+		if (expression(SCANNED_ARG(current))) return TRUE;
+	});
 	return FALSE;
 }
 
-// ReplaceAt
-bool_t replace_at(const T item, list_t list, int index)
+// All
+bool_t all(list_t list, bool_t(*expression)(item_arg_t))
 {
-	if (list == NULL || index < 0 || index >= list->length) return FALSE;
-	bool_t fromHead = index <= list->length / 2;
-	if (fromHead)
-	{
-		int position = 0;
-		GET_HEAD_ITERATOR;
-		while (iterator != NULL)
-		{
-			if (position == index)
-			{
-				iterator->info = item;
-				SYNC_PLUS;
-				return TRUE;
-			}
-			MOVE_NEXT_W_INDEX(position);
-		}
-	}
-	else
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	SCAN_FORWARD(list, current,
 	{
-		int position = list->length - 1;
-		GET_TAIL_ITERATOR;
-		while (iterator != NULL)
-		{
-			if (position == index) return iterator->info;
-			{
-				iterator->info = item;
-				SYNC_PLUS;
-				return TRUE;
-			}
-			MOVE_BACK_W_INDEX(position);
-		}
-	}
-	return FALSE;
+		if (!expression(SCANNED_ARG(current))) return FALSE;
+	});
+	return TRUE;
 }
 
-// ReplaceAllItems
-int replace_all_items(const T target, const T replacement, list_t list)
+// Skip
+list_t skip(list_t list, int count)
 {
-	RETURN_IF_EMPTY(list, -1);
-	GET_HEAD_ITERATOR;
-	int total = 0;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	if (count >= list->length) return NULL;
+	list_t outList = create();
+	if (count >= 0) appendRange(outList, list, count, list->length - count);
+	return outList;
+}
+
+// SkipWhile
+list_t skip_while(list_t list, bool_t(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	list_t outList = create();
+	bool_t triggered = FALSE;
+	SCAN_FORWARD(list, current,
 	{
-		if (iterator->info == target)
+		if (!triggered)
 		{
-			iterator->info = replacement;
-			total++;
+			if (expression(SCANNED_ARG(current))) continue;
+			else triggered = TRUE;
 		}
-		MOVE_NEXT;
-	}
-	if (total != 0) SYNC_PLUS;
-	return total == 0 ? -1 : total;
+		add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
 }
 
-// Swap
-bool_t swap(list_t list, int index1, int index2)
+// ForEach
+bool_t for_each(list_t list, void(*expression)(item_arg_t))
 {
+	READ_LOCK(list);
 	RETURN_IF_EMPTY(list, FALSE);
-	if (index1 < 0 || index1 >= list->length || index2 < 0
-		|| index2 >= list->length || index1==index2) return FALSE;
-	T temp1, temp2;
-	get(list, index1, &temp1);
-	get(list, index2, &temp2);
-	replace_at(temp2, list, index1);
-	replace_at(temp1, list, index2);
-	return TRUE;
-}
-
-// FormattedPrint
-bool_t formatted_print(char* pattern, list_t list)
-{
-	if (list == NULL)
+	SCAN_FORWARD(list, current,
 	{
-		printf("NULL list");
-		return FALSE;
-	}
-	if (list->length == 0)
-	{
-		printf("Empty list");
-		return FALSE;
-	}
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
-	{
-		printf(pattern, iterator->info);
-		if (iterator->next != NULL) printf(", ");
-		MOVE_NEXT;
-	}
+		expression(SCANNED_ARG(current));
+	});
 	return TRUE;
 }
 
-// Print
-bool_t print(char* pattern, list_t list)
+// InverseForEach
+bool_t inverse_for_each(list_t list, void(*expression)(item_arg_t))
 {
-	if (list == NULL) return FALSE;
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	SCAN_BACKWARD(list, current,
 	{
-		printf(pattern, iterator->info);
-		MOVE_NEXT;
-	}
+		expression(SCANNED_ARG(current));
+	});
 	return TRUE;
 }
 
-/* ============================================================================
-*  stack_t
-*  ========================================================================= */
+// Without an expression the items are compared with == (or LIST_EQUALS),
+// so the bloom filter and the hash index of the list_t can be used
+#define LIST_CONTAINS(list, item)                                       \
+bool_t found = FALSE;                                                   \
+if (expression == NULL) found = containsItem(list, SCANNED_ITEM(item)); \
+else SCAN_FORWARD(list, other,                                          \
+{                                                                       \
+	if (expression(SCANNED_ARG(item), SCANNED_ARG(other)))              \
+	{                                                                   \
+		found = TRUE;                                                   \
+		break;                                                          \
+	}                                                                   \
+})
 
-// Push
-bool_t push(const T item, stack_t stack)
+#define NULL_IF_EITHER_ONE_NULL                  \
+if (list1 == NULL || list2 == NULL) return NULL
+
+// Join
+list_t join(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	if (stack == NULL) return FALSE;
-	if (stack->length == 0)
+	READ_LOCK_PAIR;
+	NULL_IF_EITHER_ONE_NULL;
+	if (list1->length == 0) return copy(list2);
+	list_t outList = copy(list1);
+	if (list2->length == 0) return outList;
+	SCAN_FORWARD(list2, current,
 	{
-		return add(item, stack);
-	}
-	nodePointer newNode = (nodePointer)malloc(sizeof(listNode));
-	newNode->info = item;
-	newNode->previous = NULL;
-	stack->head->previous = newNode;
-	newNode->next = stack->head;
-	stack->head = newNode;
-	stack->length++;
-	stack->sync++;
-	return TRUE;
+		LIST_CONTAINS(list1, current);
+		if (!found) add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
 }
 
-// Pop
-bool_t pop(stack_t stack, T* result)
+// JoinWhere
+list_t join_where(list_t list1, list_t list2, bool_t(*condition)(item_arg_t), bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	RETURN_IF_EMPTY(stack, FALSE);
-	*result = stack->head->info;
-	if (stack->length == 1)
+	READ_LOCK_PAIR;
+	NULL_IF_EITHER_ONE_NULL;
+	if (list1->length == 0 && list2->length == 0) return create();
+	if (list1->length == 0) return where(list2, condition);
+	if (list2->length == 0) return where(list1, condition);
+	list_t outList = create();
+	SCAN_FORWARD(list1, current,
 	{
-		free(stack->head);
-		stack->head = NULL;
-		stack->tail = NULL;
-	}
-	else
+		if (condition(SCANNED_ARG(current))) add(SCANNED_ITEM(current), outList);
+	});
+	SCAN_FORWARD(list2, current,
 	{
-		nodePointer temp = stack->head;
-		stack->head = temp->next;
-		stack->head->previous = NULL;
-		free(temp);
-	}
-	stack->length--;
-	stack->sync++;
-	return TRUE;
+		if (condition(SCANNED_ARG(current)))
+		{
+			LIST_CONTAINS(outList, current);
+			if (!found) add(SCANNED_ITEM(current), outList);
+		}
+	});
+	return outList;
 }
 
-// Peek
-bool_t peek(stack_t stack, T* result)
+// Intersect
+list_t intersect(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	return GetFirst(stack, result);
+	READ_LOCK_PAIR;
+	NULL_IF_EITHER_ONE_NULL;
+	if (list1->length == 0 || list2->length == 0) return create();
+	list_t outList = create();
+	SCAN_FORWARD(list1, current,
+	{
+		LIST_CONTAINS(list2, current);
+		if (found) add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
 }
 
-/* ============================================================================
-*  LINQ
-*  ========================================================================= */
-
-// FirstOrDefault
-bool_t first_or_default(list_t list, T* result, bool_t(*expression)(T))
+// Except
+list_t except(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK_PAIR;
+	NULL_IF_EITHER_ONE_NULL;
+	if (list1->length == 0) return create();
+	if (list2->length == 0) return copy(list1);
+	list_t outList = create();
+	SCAN_FORWARD(list1, current,
 	{
-		if (expression(iterator->info))
-		{
-			*result = iterator->info;
-			return TRUE;
-		}
-		MOVE_NEXT;
-	}
-	return FALSE;
+		LIST_CONTAINS(list2, current);
+		if (!found) add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
 }
 
-// LastOrDefault
-bool_t last_or_default(list_t list, T* result, bool_t(*expression)(T))
+// Reverse
+list_t reverse(list_t list)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	GET_TAIL_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	list_t outList = create();
+	SCAN_BACKWARD(list, current,
 	{
-		if (expression(iterator->info))
-		{
-			*result = iterator->info;
-			return TRUE;
-		}
-		MOVE_BACK;
-	}
-	return FALSE;
+		add(SCANNED_ITEM(current), outList);
+	});
+	return outList;
 }
 
-// Count
-int count(list_t list, bool_t(*expression)(T))
+// ReverseRange
+list_t reverse_range(list_t list, int start, int end)
 {
-	RETURN_IF_EMPTY(list, -1);
-	int total = 0;
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	if (start < 0 || end < 0 || start >= list->length
+		|| end >= list->length || start >= end) return NULL;
+	list_t outList = copy(list);
+	while (start <= end)
 	{
-		if (expression(iterator->info)) total++;
-		MOVE_NEXT;
+		swap(outList, start, end);
+		start++;
+		end--;
 	}
+	return outList;
+}
+
+#define GET_LIST_SUM                           \
+RETURN_IF_EMPTY(list, 0);                      \
+int total = 0;                                 \
+SCAN_FORWARD(list, current,                    \
+{                                              \
+	total += expression(SCANNED_ARG(current)); \
+})
+
+// Sum
+int sum(list_t list, int(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	GET_LIST_SUM;
 	return total;
 }
 
-// FirstIndexWhere
-int first_index_where(list_t list, bool_t(*expression)(T))
+// Average
+int average(list_t list, int(*expression)(item_arg_t))
 {
-	RETURN_IF_EMPTY(list, -1);
-	int position = 0;
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	GET_LIST_SUM;
+	return total / list->length;
+}
+
+// GetNumericMin
+int get_numeric_min(list_t list, int(*expression)(item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, 0);
+	int minimum = INT_MAX;
+	SCAN_FORWARD(list, current,
 	{
-		if (expression(iterator->info)) return position;
-		MOVE_NEXT_W_INDEX(position);
-	}
-	return -1;
+		int temp = expression(SCANNED_ARG(current));
+		if (temp < minimum) minimum = temp;
+	});
+	return minimum;
+}
+
+
+// GetMin
+bool_t get_min(list_t list, T* result, comparation(*expression)(item_arg_t, item_arg_t))
+{
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	*result = FIRST_ITEM(list);
+	SCAN_FORWARD(list, current,
+	{
+		if (expression(ITEM_ARG(*result), SCANNED_ARG(current)) == GREATER) *result = SCANNED_ITEM(current);
+	});
+	return TRUE;
 }
 
-// LastIndexWhere
-int last_index_where(list_t list, bool_t(*expression)(T))
+// GetNumericMax
+int get_numeric_max(list_t list, int(*expression)(item_arg_t))
 {
-	RETURN_IF_EMPTY(list, -1);
-	int position = list->length - 1;
-	GET_TAIL_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, 0);
+	int maximum = INT_MIN;
+	SCAN_FORWARD(list, current,
 	{
-		if (expression(iterator->info)) return position;
-		MOVE_BACK_W_INDEX(position);
-	}
-	return -1;
+		int temp = expression(SCANNED_ARG(current));
+		if (temp > maximum) maximum = temp;
+	});
+	return maximum;
 }
 
-// Where
-list_t where(list_t list, bool_t(*expression)(T))
+// GetMax
+bool_t get_max(list_t list, T* result, comparation(*expression)(item_arg_t, item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	list_t outList = create();
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	RETURN_IF_EMPTY(list, FALSE);
+	*result = FIRST_ITEM(list);
+	SCAN_FORWARD(list, current,
 	{
-		if (expression(iterator->info)) add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	return outList;
+		if (expression(ITEM_ARG(*result), SCANNED_ARG(current)) == LOWER) *result = SCANNED_ITEM(current);
+	});
+	return TRUE;
 }
 
-// TakeWhile
-list_t take_while(list_t list, bool_t(*expression)(T))
+// OrderHelper
+static inline list_t orderHelper(list_t list, comparation(*expression)(item_arg_t, item_arg_t), bool_t reverse)
 {
-	NULL_IF_EMPTY(list);
-	list_t outList = create();
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	list_t outList = copy(list);
+	if (list->length == 1) return outList;
+	bool_t sorted = FALSE;
+	GET_ITERATOR(outList->head);
+	while (TRUE)
 	{
-		if (expression(iterator->info))
+		comparation result = expression(ITEM_ARG(iterator->info), ITEM_ARG(iterator->next->info));
+		if (reverse && result != EQUAL)
 		{
-			add(iterator->info, outList);
-			MOVE_NEXT;
+			result = result == GREATER ? LOWER : GREATER;
 		}
-		else break;
+		if (result == GREATER)
+		{
+			T backup = iterator->info;
+			iterator->info = iterator->next->info;
+			iterator->next->info = backup;
+			sorted = TRUE;
+		}
+		bool_t loopEnd = iterator->next->next == NULL ? TRUE : FALSE;
+		if (loopEnd && sorted)
+		{
+			iterator = outList->head;
+			sorted = FALSE;
+		}
+		else if (loopEnd) break;
+		else MOVE_NEXT;
 	}
 	return outList;
 }
 
-// TakeRange
-list_t take_range(list_t list, int start, int end)
+// InPlaceOrderBy
+list_t in_place_order_by(list_t list, comparation(*expression)(item_arg_t, item_arg_t))
 {
+	WRITE_LOCK(list, NULL);
 	NULL_IF_EMPTY(list);
-	if (start < 0 || end < 0 || start >= list->length
-		|| end >= list->length || start >= end) return NULL;
-	list_t outList = create();	
-	bool_t fromHead = start <= list->length / 2;
-	nodePointer iterator;
-	if (fromHead)
+	return orderHelper(list, expression, FALSE);
+}
+
+// InPlaceOrderByDescending
+list_t in_place_order_by_descending(list_t list, comparation(*expression)(item_arg_t, item_arg_t))
+{
+	WRITE_LOCK(list, NULL);
+	NULL_IF_EMPTY(list);
+	return orderHelper(list, expression, TRUE);
+}
+
+// Returns a new array with the items of a list_t that is not empty, sorted with the
+// given comparator, in descending order if requested. With LIST_BY_POINTER, it sorts
+// (and reverses) the pointers to the items and then copies each item just once,
+// in its final position
+static T* sortItems(list_t list, int* len, comparation(*expression)(item_arg_t, item_arg_t), bool_t descending)
+{
+	int i;
+#ifdef LIST_BY_POINTER
+	*len = list->length;
+	item_arg_t* pointers = (item_arg_t*)malloc(sizeof(item_arg_t) * list->length);
+	T* sorted = (T*)malloc(sizeof(T) * list->length);
+	if (pointers == NULL || sorted == NULL)
 	{
-		int position = 0;
-		iterator = list->head;
-		while (iterator != NULL)
-		{
-			if (position == start) break;
-			MOVE_NEXT_W_INDEX(position);
-		}
+		free(pointers);
+		free(sorted);
+		return NULL;
 	}
-	else
+	i = 0;
+	SCAN_FORWARD(list, current,
 	{
-		int position = list->length - 1;
-		iterator = list->tail;
-		while (iterator != NULL)
+		pointers[i++] = SCANNED_ARG(current);
+	});
+	introsort(pointers, list->length, expression);
+	for (i = 0; i < list->length; i++) sorted[i] = *pointers[descending ? list->length - 1 - i : i];
+	free(pointers);
+	return sorted;
+#else
+	T* sorted = to_array(list, len);
+	if (sorted == NULL) return NULL;
+	introsort(sorted, *len, expression);
+	if (descending)
+	{
+		for (i = 0; i < *len / 2; i++)
 		{
-			if (position == start) break;
-			MOVE_BACK_W_INDEX(position);
+			T temp = sorted[i];
+			sorted[i] = sorted[*len - 1 - i];
+			sorted[*len - 1 - i] = temp;
 		}
 	}
-	int elements = end + 1 - start;
-	while (elements > 0)
-	{
-		add(iterator->info, outList);
-		iterator = iterator->next;
-		elements--;
-	}
-	return outList;
+	return sorted;
+#endif
 }
 
-// Concat
-list_t concat(list_t list1, list_t list2)
+// OrderBy
+list_t order_by(list_t list, comparation(*expression)(item_arg_t, item_arg_t))
 {
-	if (list1 == NULL || list2 == NULL) return NULL;
-	if (list1->length == 0) return copy(list2);
-	list_t outList = copy(list1);
-	if (list2->length == 0) return outList;
-	GET_ITERATOR(list2->head);
-	while (iterator != NULL)
-	{
-		add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	return outList;
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	int len;
+	T* temp_vector = sortItems(list, &len, expression, FALSE);
+	if (temp_vector == NULL) return NULL;
+
+	// The new list_t takes the sorted array, without copying it again
+	return create_adopting(temp_vector, len, free);
 }
 
-#define GET_COUPLE_ITERATORS                                   \
-nodePointer iterator1 = list1->head, iterator2 = list2->head
+// OrderByDescending
+list_t order_by_descending(list_t list, comparation(*expression)(item_arg_t, item_arg_t))
+{
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	int len;
+	T* temp_vector = sortItems(list, &len, expression, TRUE);
+	if (temp_vector == NULL) return NULL;
+	return create_adopting(temp_vector, len, free);
+}
 
-// Zip
-list_t zip(list_t list1, list_t list2, T(*expression)(T, T))
+/* ============== Other LINQ functions ============== */
+
+#define GET_DISTINCT_LIST                                       \
+list_t outList = create();                                      \
+SCAN_FORWARD(list, current,                                     \
+{                                                               \
+	LIST_CONTAINS(outList, current);                            \
+	if (!found) add(SCANNED_ITEM(current), outList);                          \
+})
+
+// Distinct
+list_t distinct(list_t list, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	if (CHECK_EMPTY(list1) || CHECK_EMPTY(list2)) return NULL;
-	GET_COUPLE_ITERATORS;
-	list_t outList = create();
-	while (iterator1 != NULL && iterator2 != NULL)
-	{
-		add(expression(iterator1->info, iterator2->info), outList);
-		iterator1 = iterator1->next;
-		iterator2 = iterator2->next;
-	}
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	GET_DISTINCT_LIST;
 	return outList;
 }
 
-// Any
-bool_t any(list_t list, bool_t(*expression)(T))
+// CountDistinct
+int count_distinct(list_t list, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
-	{
-		if (expression(iterator->info)) return TRUE;
-		MOVE_NEXT;
-	}
-	return FALSE;
+	READ_LOCK(list);
+	if (list == NULL) return -1;
+	if (list->length == 0) return 0;
+	GET_DISTINCT_LIST;
+	return outList->length;
 }
 
-// All
-bool_t all(list_t list, bool_t(*expression)(T))
+// Single
+bool_t single(list_t list, T* result, bool_t(*expression)(item_arg_t))
 {
+	READ_LOCK(list);
 	RETURN_IF_EMPTY(list, FALSE);
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	bool_t found = FALSE;
+	SCAN_FORWARD(list, current,
 	{
-		if (!expression(iterator->info)) return FALSE;
-		MOVE_NEXT;
-	}
-	return TRUE;
+		if (expression(SCANNED_ARG(current)))
+		{
+			if (found) return FALSE;
+			found = TRUE;
+			*result = SCANNED_ITEM(current);
+		}
+	});
+	return found;
 }
 
-// Skip
-list_t skip(list_t list, int count)
+// RemoveWhere
+list_t remove_where(list_t list, bool_t(*expression)(item_arg_t))
 {
+	READ_LOCK(list);
 	NULL_IF_EMPTY(list);
-	if (count >= list->length) return NULL;
 	list_t outList = create();
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	SCAN_FORWARD(list, current,
 	{
-		if (count) count--;
-		else add(iterator->info, outList);
-		MOVE_NEXT;
-	}
+		if (!expression(SCANNED_ARG(current))) add(SCANNED_ITEM(current), outList);
+	});
 	return outList;
 }
 
-// SkipWhile
-list_t skip_while(list_t list, bool_t(*expression)(T))
+// ReplaceWhere
+list_t replace_where(list_t list, const T replacement, bool_t(*expression)(item_arg_t))
 {
+	READ_LOCK(list);
 	NULL_IF_EMPTY(list);
 	list_t outList = create();
-	bool_t triggered = FALSE;
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	SCAN_FORWARD(list, current,
 	{
-		if (!triggered)
-		{
-			if (expression(iterator->info))
-			{
-				MOVE_NEXT;
-				continue;
-			}
-			else triggered = TRUE;
-		}
-		add(iterator->info, outList);
-		MOVE_NEXT;
-	}
+		if (expression(SCANNED_ARG(current))) add(replacement, outList);
+		else add(SCANNED_ITEM(current), outList);
+	});
 	return outList;
 }
 
-// ForEach
-bool_t for_each(list_t list, void(*expression)(T))
+// Derive
+list_t derive(list_t list, T(*expression)(item_arg_t))
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	list_t outList = create();
+	SCAN_FORWARD(list, current,
 	{
-		expression(iterator->info);
-		MOVE_NEXT;
-	}
-	return TRUE;
+		add(expression(SCANNED_ARG(current)), outList);
+	});
+	return outList;
 }
 
-// InverseForEach
-bool_t inverse_for_each(list_t list, void(*expression)(T))
+// SequenceEquals
+bool_t sequence_equals(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	GET_TAIL_ITERATOR;
-	while (iterator != NULL)
+	READ_LOCK_PAIR;
+	if (list1 == NULL || list2 == NULL)
+	{
+		return list1 == NULL && list2 == NULL;
+	}
+	if (list1->length != list2->length) return FALSE;
+	GET_COUPLE_ITERATORS;
+	int i;
+	for (i = 0; i < list1->length; i++)
 	{
-		expression(iterator->info);
-		MOVE_BACK;
+		const T* item1 = itemAt(list1, &iterator1, i);
+		if (!expression(ITEM_ARG(*item1), ITEM_ARG(*itemAt(list2, &iterator2, i)))) return FALSE;
 	}
 	return TRUE;
 }
 
-#define LIST_CONTAINS(list)                                 \
-nodePointer backupIterator = list->head;                    \
-bool_t found = FALSE;                                       \
-while (backupIterator != NULL)                              \
-{                                                           \
-	if (expression(iterator->info, backupIterator->info))   \
-	{                                                       \
-		found = TRUE;                                       \
-		break;                                              \
-	}                                                       \
-	backupIterator = backupIterator->next;                  \
+// Trim
+list_t trim(list_t list, int length)
+{
+	READ_LOCK(list);
+	NULL_IF_EMPTY(list);
+	if (list->length <= length) return copy(list);
+	list_t outList = create();
+	appendRange(outList, list, 0, length);
+	return outList;
 }
 
-#define NULL_IF_EITHER_ONE_NULL                  \
-if (list1 == NULL || list2 == NULL) return NULL
+/* ================== Grouping ================== */
 
-// Join
-list_t join(list_t list1, list_t list2, bool_t(*expression)(T, T))
+// The values computed for each group of a lookup_t
+typedef enum { GROUP_ITEMS, GROUP_COUNT, GROUP_SUM, GROUP_MIN, GROUP_MAX } groupMode;
+
+// Minimum number of items for each thread used by group_by_parallel
+#define GROUP_ITEMS_PER_THREAD 4096
+
+// Maximum number of threads used by group_by_parallel
+#define GROUP_MAX_THREADS 64
+
+/* ---------------------------------------------------------------------
+*  lookupGroup
+*  ---------------------------------------------------------------------
+*  Description:
+*    A group of a lookup_t: its key, the hash of the key, the list_t with
+*    its items (only for group_by) and its value, that is the number of
+*    its items or the sum, min or max of their numeric values. */
+struct lookupGroup
 {
-	NULL_IF_EITHER_ONE_NULL;
-	if (list1->length == 0) return copy(list2);
-	list_t outList = copy(list1);
-	if (list2->length == 0) return outList;
-	GET_ITERATOR(list2->head);
-	while (iterator != NULL)
-	{
-		LIST_CONTAINS(list1);
-		if (!found) add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	return outList;
-}
+	T key;
+	size_t hash;
+	list_t items;
+	int value;
+};
 
-// JoinWhere
-list_t join_where(list_t list1, list_t list2, bool_t(*condition)(T), bool_t(*expression)(T, T))
+/* ---------------------------------------------------------------------
+*  lookupTable
+*  ---------------------------------------------------------------------
+*  Description:
+*    The groups are stored in the order of their first item, while slots
+*    is an open addressing table (with mask + 1 slots, a power of 2) with
+*    the position + 1 of each group, or 0 for an empty slot. hash and
+*    equals are the functions used for the keys, or NULL. */
+struct lookupTable
 {
-	NULL_IF_EITHER_ONE_NULL;
-	if (list1->length == 0 && list2->length == 0) return create();
-	if (list1->length == 0) return where(list2, condition);
-	if (list2->length == 0) return where(list1, condition);
-	list_t outList = create();
-	GET_ITERATOR(list1->head);
-	while (iterator != NULL)
-	{
-		if (condition(iterator->info)) add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	iterator = list2->head;
-	while (iterator != NULL)
+	struct lookupGroup* groups;
+	int length;
+	int capacity;
+	int* slots;
+	int mask;
+	groupMode mode;
+	size_t(*hash)(item_arg_t);
+	bool_t(*equals)(item_arg_t, item_arg_t);
+};
+
+// Creates an empty lookup_t, or returns NULL if there isn't enough memory
+static lookup_t createLookup(groupMode mode, size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
+{
+	lookup_t lookup = (lookup_t)malloc(sizeof(struct lookupTable));
+	if (lookup == NULL) return NULL;
+	lookup->groups = (struct lookupGroup*)malloc(sizeof(struct lookupGroup) * 8);
+	lookup->slots = (int*)calloc(16, sizeof(int));
+	if (lookup->groups == NULL || lookup->slots == NULL)
 	{
-		if (condition(iterator->info)) 
-		{
-			LIST_CONTAINS(outList);
-			if (!found) add(iterator->info, outList);
-		}
-		MOVE_NEXT;
+		free(lookup->groups);
+		free(lookup->slots);
+		free(lookup);
+		return NULL;
 	}
-	return outList;
+	lookup->length = 0;
+	lookup->capacity = 8;
+	lookup->mask = 15;
+	lookup->mode = mode;
+	lookup->hash = hash;
+	lookup->equals = equals;
+	return lookup;
 }
 
-// Intersect
-list_t intersect(list_t list1, list_t list2, bool_t(*expression)(T, T))
+// Returns the hash of a key, with the hash function of the lookup_t or with
+// the one of the hash index
+static inline size_t hashKey(lookup_t lookup, const T key)
 {
-	NULL_IF_EITHER_ONE_NULL;
-	if (list1->length == 0 || list2->length == 0) return create();
-	list_t outList = create();
-	GET_ITERATOR(list1->head);
-	while (iterator != NULL)
-	{
-		LIST_CONTAINS(list2);
-		if (found) add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	return outList;
+	return lookup->hash != NULL ? lookup->hash(ITEM_ARG(key)) : hashItem(key);
+}
+
+// Checks if a group has the given key
+static inline bool_t hasKey(lookup_t lookup, struct lookupGroup* group, size_t hash, const T key)
+{
+	if (group->hash != hash) return FALSE;
+	return lookup->equals != NULL
+		? lookup->equals(ITEM_ARG(group->key), ITEM_ARG(key))
+		: ITEMS_EQUAL(group->key, key);
 }
 
-// Except
-list_t except(list_t list1, list_t list2, bool_t(*expression)(T, T))
+// Returns the group with the given key, or NULL if there isn't one
+static struct lookupGroup* findGroup(lookup_t lookup, const T key, size_t hash)
 {
-	NULL_IF_EITHER_ONE_NULL;
-	if (list1->length == 0) return create();
-	if (list2->length == 0) return copy(list1);
-	list_t outList = create();
-	GET_ITERATOR(list1->head);
-	while (iterator != NULL)
+	int slot = (int)(mixHash((uint64_t)hash) & (uint64_t)lookup->mask);
+	while (lookup->slots[slot] != 0)
 	{
-		LIST_CONTAINS(list2);
-		if (!found) add(iterator->info, outList);
-		MOVE_NEXT;
+		struct lookupGroup* group = lookup->groups + lookup->slots[slot] - 1;
+		if (hasKey(lookup, group, hash, key)) return group;
+		slot = (slot + 1) & lookup->mask;
 	}
-	return outList;
+	return NULL;
 }
 
-// Reverse
-list_t reverse(list_t list)
+// Doubles the slots of a lookup_t and places its groups again
+static bool_t growSlots(lookup_t lookup)
 {
-	NULL_IF_EMPTY(list);
-	list_t outList = create();
-	GET_TAIL_ITERATOR;
-	while (iterator != NULL)
+	int mask = lookup->mask * 2 + 1, i;
+	int* slots = (int*)calloc(mask + 1, sizeof(int));
+	if (slots == NULL) return FALSE;
+	for (i = 0; i < lookup->length; i++)
 	{
-		add(iterator->info, outList);
-		MOVE_BACK;
+		int slot = (int)(mixHash((uint64_t)lookup->groups[i].hash) & (uint64_t)mask);
+		while (slots[slot] != 0) slot = (slot + 1) & mask;
+		slots[slot] = i + 1;
 	}
-	return outList;
+	free(lookup->slots);
+	lookup->slots = slots;
+	lookup->mask = mask;
+	return TRUE;
 }
 
-// ReverseRange
-list_t reverse_range(list_t list, int start, int end)
+// Returns the group with the given key, adding an empty one if there isn't
+// one yet (created is set to TRUE in this case). Returns NULL if there
+// isn't enough memory for the new group
+static struct lookupGroup* getGroup(lookup_t lookup, const T key, size_t hash, bool_t* created)
 {
-	NULL_IF_EMPTY(list);
-	if (start < 0 || end < 0 || start >= list->length
-		|| end >= list->length || start >= end) return NULL;
-	list_t outList = copy(list);
-	while (start <= end)
+	*created = FALSE;
+	struct lookupGroup* group = findGroup(lookup, key, hash);
+	if (group != NULL) return group;
+
+	// Keep the table at most half full
+	if ((lookup->length + 1) * 2 > lookup->mask + 1 && !growSlots(lookup)) return NULL;
+	if (lookup->length == lookup->capacity)
 	{
-		swap(outList, start, end);
-		start++;
-		end--;
+		struct lookupGroup* groups = (struct lookupGroup*)realloc(lookup->groups,
+			sizeof(struct lookupGroup) * lookup->capacity * 2);
+		if (groups == NULL) return NULL;
+		lookup->groups = groups;
+		lookup->capacity *= 2;
 	}
-	return outList;
+	group = lookup->groups + lookup->length;
+	group->items = NULL;
+	if (lookup->mode == GROUP_ITEMS && (group->items = create()) == NULL) return NULL;
+	group->key = key;
+	group->hash = hash;
+	group->value = 0;
+	int slot = (int)(mixHash((uint64_t)hash) & (uint64_t)lookup->mask);
+	while (lookup->slots[slot] != 0) slot = (slot + 1) & lookup->mask;
+	lookup->slots[slot] = ++lookup->length;
+	*created = TRUE;
+	return group;
 }
 
-#define GET_LIST_SUM                         \
-RETURN_IF_EMPTY(list, (T)NULL);              \
-GET_HEAD_ITERATOR;                           \
-int total = 0;                               \
-while (iterator != NULL)                     \
-{                                            \
-	total += expression(iterator->info);     \
-	MOVE_NEXT;                               \
-}
-
-// Sum
-int sum(list_t list, int(*expression)(T))
+// Adds the value of an item (or a partial group, for group_by_parallel) to a group
+static inline void mergeValue(lookup_t lookup, struct lookupGroup* group, bool_t created, int value)
 {
-	GET_LIST_SUM;
-	return total;
+	switch (lookup->mode)
+	{
+		case GROUP_MIN:
+			if (created || value < group->value) group->value = value;
+			break;
+		case GROUP_MAX:
+			if (created || value > group->value) group->value = value;
+			break;
+		default:
+			group->value += value;
+	}
 }
 
-// Average
-int average(list_t list, int(*expression)(T))
+// Adds an item to the group of its key. Returns FALSE if there isn't enough memory
+static bool_t groupItem(lookup_t lookup, const T* item,
+	T(*key)(item_arg_t), int(*expression)(item_arg_t))
 {
-	GET_LIST_SUM;
-	return total / list->length;
+	T itemKey = key(ITEM_ARG(*item));
+	bool_t created;
+	struct lookupGroup* group = getGroup(lookup, itemKey, hashKey(lookup, itemKey), &created);
+	if (group == NULL) return FALSE;
+	if (lookup->mode == GROUP_ITEMS && !add(*item, group->items)) return FALSE;
+	mergeValue(lookup, group, created,
+		lookup->mode == GROUP_SUM || lookup->mode == GROUP_MIN || lookup->mode == GROUP_MAX
+		? expression(ITEM_ARG(*item)) : 1);
+	return TRUE;
 }
 
-// GetNumericMin
-int get_numeric_min(list_t list, int(*expression)(T))
+// Adds the items of a list_t to a new lookup_t, or returns NULL if there isn't enough memory
+static lookup_t groupList(list_t list, groupMode mode, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
 {
-	RETURN_IF_EMPTY(list, (T)NULL);
-	GET_HEAD_ITERATOR;
-	int minimum = INT_MAX;
-	while (iterator != NULL)
+	lookup_t lookup = createLookup(mode, hash, equals);
+	if (lookup == NULL) return NULL;
+	bool_t failed = FALSE;
+	SCAN_FORWARD(list, current,
 	{
-		int temp = expression(iterator->info);
-		if (temp < minimum) minimum = temp;
-		MOVE_NEXT;
-	}
-	return minimum;
+		if (!groupItem(lookup, &SCANNED_ITEM(current), key, expression))
+		{
+			failed = TRUE;
+			break;
+		}
+	});
+	if (failed) destroy_lookup(&lookup);
+	return lookup;
 }
 
-#define FIRST_IF_SINGLE_ITEM if (list->length == 1) return list->head->info
+/* ---------------------------------------------------------------------
+*  groupTask
+*  ---------------------------------------------------------------------
+*  Description:
+*    The range of a list_t grouped by a thread of group_by_parallel:
+*    count items starting from items (for an array list_t) or from the
+*    first node. The thread fills the partial lookup_t of the range. */
+struct groupTask
+{
+	pthread_t thread;
+	const T* items;
+	nodePointer first;
+	int count;
+	T(*key)(item_arg_t);
+	lookup_t lookup;
+	bool_t failed;
+};
 
-// GetMin
-bool_t get_min(list_t list, T* result, comparation(*expression)(T, T))
+// Groups the items of the range of a groupTask
+static void* groupRange(void* arg)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	FIRST_IF_SINGLE_ITEM;
-	GET_HEAD_ITERATOR;
-	*result = iterator->info;
-	MOVE_NEXT;
-	while (iterator != NULL)
+	struct groupTask* task = (struct groupTask*)arg;
+	int i;
+	if (task->items != NULL)
 	{
-		if (expression(*result, iterator->info) == GREATER) *result = iterator->info;
-		MOVE_NEXT;
+		for (i = 0; i < task->count && !task->failed; i++)
+		{
+			task->failed = !groupItem(task->lookup, task->items + i, task->key, NULL);
+		}
 	}
-	return TRUE;
-}
-
-// GetNumericMax
-int get_numeric_max(list_t list, int(*expression)(T))
-{
-	RETURN_IF_EMPTY(list, (T)NULL);
-	GET_HEAD_ITERATOR;
-	int maximum = INT_MIN;
-	while (iterator != NULL)
+	else
 	{
-		int temp = expression(iterator->info);
-		if (temp > maximum) maximum = temp;
-		MOVE_NEXT;
+		nodePointer node = task->first;
+		for (i = 0; i < task->count && !task->failed; i++)
+		{
+			task->failed = !groupItem(task->lookup, &node->info, task->key, NULL);
+			if (i != task->count - 1) node = node->next;
+		}
 	}
-	return maximum;
+	return NULL;
 }
 
-// GetMax
-bool_t get_max(list_t list, T* result, comparation(*expression)(T, T))
+// Moves the groups of a partial lookup_t inside the final one, after its
+// current items. Returns FALSE if there isn't enough memory
+static bool_t mergeLookup(lookup_t lookup, lookup_t partial)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	FIRST_IF_SINGLE_ITEM;
-	GET_HEAD_ITERATOR;
-	*result = iterator->info;
-	MOVE_NEXT;
-	while (iterator != NULL)
+	int i;
+	for (i = 0; i < partial->length; i++)
 	{
-		if (expression(*result, iterator->info) == LOWER) *result = iterator->info;
-		MOVE_NEXT;
+		struct lookupGroup* source = partial->groups + i;
+		bool_t created;
+		struct lookupGroup* group = getGroup(lookup, source->key, source->hash, &created);
+		if (group == NULL) return FALSE;
+		mergeValue(lookup, group, created, source->value);
+		if (created)
+		{
+			// Take the list_t of the partial group instead of copying it
+			destroy(&group->items);
+			group->items = source->items;
+			source->items = NULL;
+		}
+		else if (!add_all(group->items, source->items)) return FALSE;
 	}
 	return TRUE;
 }
 
-// OrderHelper
-static inline list_t orderHelper(list_t list, comparation(*expression)(T, T), bool_t reverse)
+// Checks the arguments of the grouping functions
+#define NULL_IF_NO_GROUPS \
+if (list == NULL || STALE_SLICE(list) || key == NULL) return NULL
+
+// GroupBy
+lookup_t group_by(list_t list, T(*key)(item_arg_t), size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
 {
-	list_t outList = copy(list);
-	if (list->length == 1) return outList;
-	bool_t sorted = FALSE;
-	GET_ITERATOR(outList->head);
-	while (TRUE)
+	READ_LOCK(list);
+	NULL_IF_NO_GROUPS;
+	return groupList(list, GROUP_ITEMS, key, NULL, hash, equals);
+}
+
+// GroupByParallel
+lookup_t group_by_parallel(list_t list, T(*key)(item_arg_t), size_t(*hash)(item_arg_t),
+	bool_t(*equals)(item_arg_t, item_arg_t), int threads)
+{
+	READ_LOCK(list);
+	NULL_IF_NO_GROUPS;
+	if (threads > list->length / GROUP_ITEMS_PER_THREAD) threads = list->length / GROUP_ITEMS_PER_THREAD;
+	if (threads > GROUP_MAX_THREADS) threads = GROUP_MAX_THREADS;
+	if (threads < 2) return groupList(list, GROUP_ITEMS, key, NULL, hash, equals);
+
+	// Split the list_t into consecutive ranges, so that merging the partial
+	// lookups in order keeps the order of the keys and of the items
+	struct groupTask tasks[GROUP_MAX_THREADS];
+	nodePointer node = list->head;
+	int i, j, started = 0, start = 0;
+	for (i = 0; i < threads; i++)
 	{
-		comparation result = expression(iterator->info, iterator->next->info);
-		if (reverse && result != EQUAL)
+		tasks[i].count = list->length / threads + (i < list->length % threads);
+		tasks[i].items = list->items != NULL ? list->items + start : NULL;
+		tasks[i].first = node;
+		tasks[i].key = key;
+		tasks[i].failed = FALSE;
+		tasks[i].lookup = createLookup(GROUP_ITEMS, hash, equals);
+		if (tasks[i].lookup == NULL) break;
+		if (list->items == NULL && i < threads - 1)
 		{
-			result = result == GREATER ? LOWER : GREATER;
+			for (j = 0; j < tasks[i].count; j++) node = node->next;
 		}
-		if (result == GREATER)
+		start += tasks[i].count;
+	}
+
+	// Run the ranges, the last one in the current thread
+	bool_t failed = i < threads;
+	if (!failed)
+	{
+		for (; started < threads - 1; started++)
 		{
-			T backup = iterator->info;
-			iterator->info = iterator->next->info;
-			iterator->next->info = backup;
-			sorted = TRUE;
+			if (pthread_create(&tasks[started].thread, NULL, groupRange, tasks + started) != 0) break;
 		}
-		bool_t loopEnd = iterator->next->next == NULL ? TRUE : FALSE;
-		if (loopEnd && sorted)
+		for (i = started; i < threads; i++) groupRange(tasks + i);
+		for (i = 0; i < started; i++) pthread_join(tasks[i].thread, NULL);
+	}
+	else threads = i;
+
+	// Merge the partial lookups in order
+	lookup_t lookup = failed ? NULL : createLookup(GROUP_ITEMS, hash, equals);
+	for (i = 0; i < threads; i++)
+	{
+		if (lookup != NULL && (tasks[i].failed || !mergeLookup(lookup, tasks[i].lookup)))
 		{
-			iterator = outList->head;
-			sorted = FALSE;
+			destroy_lookup(&lookup);
 		}
-		else if (loopEnd) break;
-		else MOVE_NEXT;
+		destroy_lookup(&tasks[i].lookup);
 	}
-	return outList;
+	return lookup;
 }
 
-// InPlaceOrderBy
-list_t in_place_order_by(list_t list, comparation(*expression)(T, T))
+// CountBy
+lookup_t count_by(list_t list, T(*key)(item_arg_t), size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	return orderHelper(list, expression, FALSE);
+	READ_LOCK(list);
+	NULL_IF_NO_GROUPS;
+	return groupList(list, GROUP_COUNT, key, NULL, hash, equals);
 }
 
-// InPlaceOrderByDescending
-list_t in_place_order_by_descending(list_t list, comparation(*expression)(T, T))
+// Checks the arguments of the functions that aggregate the numeric values of the groups
+#define NULL_IF_NO_AGGREGATE \
+NULL_IF_NO_GROUPS;           \
+if (expression == NULL) return NULL
+
+// SumBy
+lookup_t sum_by(list_t list, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	return orderHelper(list, expression, TRUE);
+	READ_LOCK(list);
+	NULL_IF_NO_AGGREGATE;
+	return groupList(list, GROUP_SUM, key, expression, hash, equals);
 }
 
-// OrderBy
-list_t order_by(list_t list, comparation(*expression)(T, T))
+// MinBy
+lookup_t min_by(list_t list, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	int len;
-	T* temp_vector = to_array(list, &len);
-	introsort(temp_vector, len, expression);
-	list = create_from(temp_vector, len);
-	free(temp_vector);
-	return list;
+	READ_LOCK(list);
+	NULL_IF_NO_AGGREGATE;
+	return groupList(list, GROUP_MIN, key, expression, hash, equals);
 }
 
-// OrderByDescending
-list_t order_by_descending(list_t list, comparation(*expression)(T, T))
+// MaxBy
+lookup_t max_by(list_t list, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t))
 {
-	// Get the sorted array
-	NULL_IF_EMPTY(list);
-	int len;
-	T* temp_vector = to_array(list, &len);
-	introsort(temp_vector, len, expression);
+	READ_LOCK(list);
+	NULL_IF_NO_AGGREGATE;
+	return groupList(list, GROUP_MAX, key, expression, hash, equals);
+}
 
-	// Reverse the array and return a new list
-	int i, target = len >> 1;
-	for (i = 0; i < target; i++)
-	{
-		T temp = temp_vector[i];
-		temp_vector[i] = temp_vector[target];
-		temp_vector[target] = temp;
-		target--;
-	}
-	list = create_from(temp_vector, len);
-	free(temp_vector);
-	return list;
+// LookupSize
+int lookup_size(lookup_t lookup)
+{
+	return lookup == NULL ? -1 : lookup->length;
 }
 
-/* ============== Other LINQ functions ============== */
+// LookupGet
+list_t lookup_get(lookup_t lookup, const T key)
+{
+	if (lookup == NULL || lookup->mode != GROUP_ITEMS) return NULL;
+	struct lookupGroup* group = findGroup(lookup, key, hashKey(lookup, key));
+	return group == NULL ? NULL : group->items;
+}
 
-#define GET_DISTINCT_LIST                                       \
-list_t outList = create();                                    \
-GET_HEAD_ITERATOR;                                              \
-while (iterator != NULL)                                        \
-{                                                               \
-	nodePointer testIterator = outList->head;                 \
-	bool_t found = FALSE;                                       \
-	while (testIterator != NULL)                                \
-	{                                                           \
-		if (expression(iterator->info, testIterator->info))     \
-		{                                                       \
-			found = TRUE;                                       \
-			break;                                              \
-		}                                                       \
-		testIterator = testIterator->next;                      \
-	}                                                           \
-	if (!found) add(iterator->info, outList);                 \
-	MOVE_NEXT;                                                  \
+// LookupValue
+bool_t lookup_value(lookup_t lookup, const T key, int* result)
+{
+	if (lookup == NULL || result == NULL) return FALSE;
+	struct lookupGroup* group = findGroup(lookup, key, hashKey(lookup, key));
+	if (group == NULL) return FALSE;
+	*result = group->value;
+	return TRUE;
 }
 
-// Distinct
-list_t distinct(list_t list, bool_t(*expression)(T, T))
+// LookupKeys
+list_t lookup_keys(lookup_t lookup)
 {
-	NULL_IF_EMPTY(list);
-	GET_DISTINCT_LIST;
+	if (lookup == NULL) return NULL;
+	list_t outList = create();
+	int i;
+	for (i = 0; i < lookup->length; i++) add(lookup->groups[i].key, outList);
 	return outList;
 }
 
-// CountDistinct
-int count_distinct(list_t list, bool_t(*expression)(T, T))
+// DestroyLookup
+bool_t destroy_lookup(lookup_t* lookup)
 {
-	if (list == NULL) return -1;
-	if (list->length == 0) return 0;
-	GET_DISTINCT_LIST;
-	return outList->length;
+	if (lookup == NULL || *lookup == NULL) return FALSE;
+	int i;
+	for (i = 0; i < (*lookup)->length; i++)
+	{
+		if ((*lookup)->groups[i].items != NULL) destroy(&(*lookup)->groups[i].items);
+	}
+	free((*lookup)->groups);
+	free((*lookup)->slots);
+	free(*lookup);
+	*lookup = NULL;
+	return TRUE;
 }
 
-// Single
-bool_t single(list_t list, T* result, bool_t(*expression)(T))
+/* ============================================================================
+*  In-place LINQ
+*  ========================================================================= */
+
+// Removes all the nodes whose expression result matches the given value
+static int removeWhereHelper(list_t list, bool_t(*expression)(item_arg_t), bool_t value)
 {
-	RETURN_IF_EMPTY(list, FALSE);
-	bool_t found = FALSE;
+	RETURN_IF_EMPTY(list, -1);
+	ENSURE_NODES(list, -1);
+	int total = 0;
 	GET_HEAD_ITERATOR;
 	while (iterator != NULL)
 	{
-		if (expression(iterator->info))
+		nodePointer temp = iterator;
+		MOVE_NEXT;
+		if ((expression(ITEM_ARG(temp->info)) ? TRUE : FALSE) == value)
 		{
-			if (found) return FALSE;
-			found = TRUE;
-			*result = iterator->info;
+			unlinkNode(list, temp);
+			total++;
 		}
-		MOVE_NEXT;
 	}
-	return found;
+	if (total != 0) SYNC_PLUS;
+	return total;
 }
 
-// RemoveWhere
-list_t remove_where(list_t list, bool_t(*expression)(T))
+// WhereInPlace
+int where_in_place(list_t list, bool_t(*expression)(item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	list_t outList = create();
-	GET_HEAD_ITERATOR;
-	while (iterator != NULL)
-	{
-		if (!expression(iterator->info)) add(iterator->info, outList);
-		MOVE_NEXT;
-	}
-	return outList;
+	WRITE_LOCK(list, -1);
+	return removeWhereHelper(list, expression, FALSE);
 }
 
-// ReplaceWhere
-list_t replace_where(list_t list, const T replacement, bool_t(*expression)(T))
+// RemoveWhereInPlace
+int remove_where_in_place(list_t list, bool_t(*expression)(item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	list_t outList = create();
+	WRITE_LOCK(list, -1);
+	return removeWhereHelper(list, expression, TRUE);
+}
+
+// ReplaceWhereInPlace
+int replace_where_in_place(list_t list, const T replacement, bool_t(*expression)(item_arg_t))
+{
+	WRITE_LOCK(list, -1);
+	RETURN_IF_EMPTY(list, -1);
+	ENSURE_REPLACE(list, -1);
+	int total = 0;
 	GET_HEAD_ITERATOR;
 	while (iterator != NULL)
 	{
-		if (expression(iterator->info)) add(replacement, outList);
-		else add(iterator->info, outList);
+		if (expression(ITEM_ARG(iterator->info)))
+		{
+			iterator->info = replacement;
+			total++;
+		}
 		MOVE_NEXT;
 	}
-	return outList;
+	if (total != 0)
+	{
+		REBUILD_INDEX(list);
+		SYNC_PLUS;
+	}
+	return total;
 }
 
-// Derive
-list_t derive(list_t list, T(*expression)(T))
+// DeriveInPlace
+bool_t derive_in_place(list_t list, T(*expression)(item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	list_t outList = create();
+	WRITE_LOCK(list, FALSE);
+	RETURN_IF_EMPTY(list, FALSE);
+	ENSURE_REPLACE(list, FALSE);
 	GET_HEAD_ITERATOR;
 	while (iterator != NULL)
 	{
-		add(expression(iterator->info), outList);
+		iterator->info = expression(ITEM_ARG(iterator->info));
 		MOVE_NEXT;
 	}
-	return outList;
+	REBUILD_INDEX(list);
+	SYNC_PLUS;
+	return TRUE;
 }
 
-// SequenceEquals
-bool_t sequence_equals(list_t list1, list_t list2, bool_t(*expression)(T, T))
+// ReverseInPlace
+bool_t reverse_in_place(list_t list)
 {
-	if (list1 == NULL || list2 == NULL)
-	{
-		return list1 == NULL && list2 == NULL;
-	}
-	if (list1->length != list2->length) return FALSE;
-	GET_COUPLE_ITERATORS;
-	while (iterator1 != NULL)
+	WRITE_LOCK(list, FALSE);
+	RETURN_IF_EMPTY(list, FALSE);
+	ENSURE_NODES(list, FALSE);
+	GET_HEAD_ITERATOR;
+	while (iterator != NULL)
 	{
-		if (!expression(iterator1->info, iterator2->info)) return FALSE;
-		iterator1 = iterator1->next;
-		iterator2 = iterator2->next;
+		nodePointer temp = iterator->next;
+		iterator->next = iterator->previous;
+		iterator->previous = temp;
+		iterator = temp;
 	}
+	iterator = list->head;
+	list->head = list->tail;
+	list->tail = iterator;
+	REBUILD_INDEX(list);
+	SYNC_PLUS;
 	return TRUE;
 }
 
-// Trim
-list_t trim(list_t list, int length)
+// DistinctInPlace
+int distinct_in_place(list_t list, bool_t(*expression)(item_arg_t, item_arg_t))
 {
-	NULL_IF_EMPTY(list);
-	if (list->length <= length) return copy(list);
-	list_t outList = create();
-	GET_HEAD_ITERATOR;
-	int position = 0;
-	while (position < length)
+	WRITE_LOCK(list, -1);
+	RETURN_IF_EMPTY(list, -1);
+	ENSURE_NODES(list, -1);
+	int total = 0;
+	GET_ITERATOR(list->head->next);
+	while (iterator != NULL)
 	{
-		add(iterator->info, outList);
-		MOVE_NEXT_W_INDEX(position);
+		nodePointer testIterator = list->head;
+		bool_t found = FALSE;
+		while (testIterator != iterator)
+		{
+			if (expression(ITEM_ARG(iterator->info), ITEM_ARG(testIterator->info)))
+			{
+				found = TRUE;
+				break;
+			}
+			testIterator = testIterator->next;
+		}
+		nodePointer temp = iterator;
+		MOVE_NEXT;
+		if (found)
+		{
+			unlinkNode(list, temp);
+			total++;
+		}
 	}
-	return outList;
+	if (total != 0) SYNC_PLUS;
+	return total;
 }
 
 /* ============================================================================
@@ -1496,6 +5894,7 @@ list_t trim(list_t list, int length)
 // GetIterator
 list_iterator_t get_iterator(list_t list)
 {
+	READ_LOCK(list);
 	NULL_IF_EMPTY(list);
 	list_iterator_t iterator = (list_iterator_t)malloc(sizeof(iteratorInstance));
 	iterator->list = list;
@@ -1518,35 +5917,44 @@ bool_t destroy_iterator(list_iterator_t* iterator)
 // IsSynced
 bool_t is_synced(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return FALSE;
-	return iterator->sync == iterator->list->sync ? TRUE : FALSE;
+	return iterator->sync == iterator->list->sync && !STALE_SLICE(iterator->list) ? TRUE : FALSE;
 }
 
 #define RETURN_IF_OUT_OF_SYNC(value)                        \
-if (iterator->sync != iterator->list->sync) return value;
+if (iterator->sync != iterator->list->sync || STALE_SLICE(iterator->list)) return value;
+
+// Gets the item pointed by an iterator, whatever the storage of its list_t is
+#define CURRENT_ITEM                                          \
+(*(iterator->list->items != NULL                              \
+	? &iterator->list->items[iterator->position]              \
+	: &iterator->pointer->info))
 
 // GetCurrent
 bool_t get_current(list_iterator_t iterator, T* result)
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return FALSE;
 	RETURN_IF_OUT_OF_SYNC(FALSE);
-	*result = iterator->pointer->info;
+	*result = CURRENT_ITEM;
 	return TRUE;
 }
 
 // Next
 bool_t next(list_iterator_t iterator, T* result)
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return FALSE;
 	RETURN_IF_OUT_OF_SYNC(FALSE);
 	if (iterator->started == FALSE)
 	{
 		iterator->started = TRUE;
-		*result = iterator->pointer->info;
+		*result = CURRENT_ITEM;
 		return TRUE;
 	}
 	if (move_next(iterator) == FALSE) return FALSE;
-	*result = iterator->pointer->info;
+	*result = CURRENT_ITEM;
 	return TRUE;
 }
 
@@ -1555,12 +5963,13 @@ static inline bool_t checkGoForward(list_iterator_t iterator)
 {
 	if (iterator == NULL) return FALSE;
 	RETURN_IF_OUT_OF_SYNC(FALSE);
-	return iterator->pointer->next != NULL ? TRUE : FALSE;
+	return iterator->position < iterator->list->length - 1 ? TRUE : FALSE;
 }
 
 // CanGoForward
 bool_t can_go_forward(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	return checkGoForward(iterator);
 }
 
@@ -1569,20 +5978,22 @@ static inline bool_t checkGoBack(list_iterator_t iterator)
 {
 	if (iterator == NULL) return FALSE;
 	RETURN_IF_OUT_OF_SYNC(FALSE);
-	return iterator->pointer->previous != NULL ? TRUE : FALSE;
+	return iterator->position > 0 ? TRUE : FALSE;
 }
 
 // CanGoBack
 bool_t can_go_back(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	return checkGoBack(iterator);
 }
 
 // MoveNext
 bool_t move_next(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	if (!checkGoForward(iterator)) return FALSE;
-	iterator->pointer = iterator->pointer->next;
+	if (iterator->pointer != NULL) iterator->pointer = iterator->pointer->next;
 	iterator->position++;
 	iterator->started = TRUE;
 	return TRUE;
@@ -1591,8 +6002,9 @@ bool_t move_next(list_iterator_t iterator)
 // MoveBack
 bool_t move_back(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	if (!checkGoBack(iterator)) return FALSE;
-	iterator->pointer = iterator->pointer->previous;
+	if (iterator->pointer != NULL) iterator->pointer = iterator->pointer->previous;
 	iterator->position--;
 	return TRUE;
 }
@@ -1600,6 +6012,7 @@ bool_t move_back(list_iterator_t iterator)
 // ActualPosition
 int actual_position(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return -1;
 	RETURN_IF_OUT_OF_SYNC(-1);
 	return iterator->position;
@@ -1608,35 +6021,73 @@ int actual_position(list_iterator_t iterator)
 // ElementsLeft
 int elements_left(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return -1;
 	RETURN_IF_OUT_OF_SYNC(-1);
 	return iterator->list->length - iterator->position;
 }
 
 // ForEachRemaining
-int for_each_remaining(list_iterator_t iterator, void(*expression)(T))
+int for_each_remaining(list_iterator_t iterator, void(*expression)(item_arg_t))
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return -1;
 	RETURN_IF_OUT_OF_SYNC(-1);
 	iterator->started = TRUE;
 	int start = iterator->position;
 	while (TRUE)
 	{
-		expression(iterator->pointer->info);
-		if (iterator->pointer->next == NULL) break;
-		iterator->pointer = iterator->pointer->next;
+		expression(ITEM_ARG(CURRENT_ITEM));
+		if (iterator->position == iterator->list->length - 1) break;
+		if (iterator->pointer != NULL) iterator->pointer = iterator->pointer->next;
 		iterator->position++;
 	}
 	return iterator->position - start;
 }
 
+// NextChunk
+int next_chunk(list_iterator_t iterator, T* buffer, int capacity)
+{
+	READ_LOCK_ITERATOR;
+	if (iterator == NULL || buffer == NULL || capacity < 0) return -1;
+	RETURN_IF_OUT_OF_SYNC(-1);
+	int start = iterator->started ? iterator->position + 1 : iterator->position;
+	int count = iterator->list->length - start;
+	if (count > capacity) count = capacity;
+	if (count <= 0) return 0;
+	if (iterator->list->items != NULL)
+	{
+		memcpy(buffer, iterator->list->items + start, sizeof(T) * count);
+	}
+	else
+	{
+		nodePointer node = iterator->started ? iterator->pointer->next : iterator->pointer;
+		int i;
+		for (i = 0; i < count; i++)
+		{
+			buffer[i] = node->info;
+			iterator->pointer = node;
+			if (i != count - 1) node = node->next;
+		}
+	}
+	iterator->position = start + count - 1;
+	iterator->started = TRUE;
+	return count;
+}
+
 // Restart
 bool_t restart(list_iterator_t iterator)
 {
+	READ_LOCK_ITERATOR;
 	if (iterator == NULL) return FALSE;
 	iterator->position = 0;
 	iterator->pointer = iterator->list->head;
 	iterator->sync = iterator->list->sync;
 	iterator->started = FALSE;
 	return TRUE;
-}
\ No newline at end of file
+}
+
+// A named list type compiles its own copy of the sorting algorithm
+#ifdef LIST_NAME
+#include "Introsort\introsort.c"
+#endif
\ No newline at end of file
@@ -6,24 +6,81 @@
 *  License:        See the end of this file for license information
 */
 
-#ifndef LIST_T_H
+// A named list type can be included again, once for each type
+#if defined(LIST_NAME) ? !defined(LIST_T_INSTANCE) : !defined(LIST_T_H)
+#ifndef LIST_NAME
 #define LIST_T_H
+#elif defined(LIST_T_C)
+#define LIST_T_INSTANCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
 
 /* =================== Define your custom Type here ====================
 *  NOTE:
 *    You can use a standard value type, a pointer type or a custom
 *    type. Just replace "int" with the type you want to use in
-*    your program and you will get your List<T> C implementation. */
-#ifndef TYPE
+*    your program and you will get your List<T> C implementation.
+*    To use lists with different types in the same program, define
+*    LIST_NAME and LIST_TYPE before each inclusion of this file: all
+*    the types and functions get the LIST_NAME_ prefix (with LIST_NAME
+*    double_list, create becomes double_list_create and list_t becomes
+*    double_list_list_t) and the macros are undefined at the end of the
+*    file. A single source file must also define the same macros before
+*    including list_t.c, to compile the functions for that type.
+*    LIST_EQUALS(a, b) can replace the == operator used to compare two
+*    items, and LIST_NOT_NUMERIC removes the functions that convert
+*    numbers into items: both are needed by a struct type.
+*    LIST_HASH(item) returns the hash of an item for the hash index (see
+*    enable_hash_index): it must be the same for the equal items.
+*    With LIST_BY_POINTER, the callbacks and the lambda expressions
+*    receive a const T* to each item instead of a copy of it (see
+*    item_arg_t below): define it for a large struct type, here for
+*    the unnamed list_t or next to LIST_TYPE for a named one.
+*    The lambda macros below always use the T of the unnamed list_t. */
+#ifdef LIST_NAME
+#include "list_names.h"
+#elif !defined(TYPE)
 #define TYPE int			
 #endif
 
 // =================== Public types ====================
+#ifdef LIST_NAME
+typedef LIST_TYPE T;
+#else
 typedef TYPE T;
+#endif
+// The type of the items received by the callbacks and lambda expressions
+#ifdef LIST_BY_POINTER
+typedef const T* item_arg_t;
+#else
+typedef T item_arg_t;
+#endif
+#ifndef LIST_T_BOOL
+#define LIST_T_BOOL
 typedef enum { FALSE, TRUE } bool_t;
+#endif
 typedef struct listIterator* list_iterator_t;
 typedef struct listBase* list_t;
 typedef list_t stack_t;
+typedef struct listStream* list_stream_t;
+typedef struct frozenList* frozen_list_t;
+typedef struct persistentList* persistent_list_t;
+typedef struct ringQueue* queue_t;
+typedef struct appendList* append_list_t;
+typedef struct rcuList* rcu_list_t;
+typedef struct lookupTable* lookup_t;
+// The counters of the bloom filter of a list_t (see get_bloom_stats)
+#ifndef LIST_T_BLOOM_STATS
+#define LIST_T_BLOOM_STATS
+typedef struct
+{
+	long long checks;
+	long long rejected;
+	long long false_positives;
+} bloom_stats_t;
+#endif
 
 /* =====================================================================
 *  Generic functions
@@ -40,6 +97,100 @@ typedef list_t stack_t;
 *    Creates an empty list_t. */
 list_t create();
 
+/* ---------------------------------------------------------------------
+*  CreateConcurrent
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates an empty list_t that can be shared by different threads:
+*    the functions that only read it (get, index_of, the LINQ functions,
+*    the iterators...) take a shared lock, so they can run at the same
+*    time, while the functions that edit it take an exclusive lock.
+*    A function called from inside an expression doesn't lock a list_t
+*    again if the current thread is already using it, so an expression
+*    can read the list_t it is called on, but it can't edit it: under
+*    the shared lock of a function that reads the list_t, the functions
+*    that edit it fail (returning FALSE, -1 or NULL) without changes.
+*    The lists returned by the other functions, like copy, where or
+*    snapshot, are normal lists. The pointers returned by to_array_borrow
+*    and the slices are only safe while no other thread edits the list_t.
+*    Returns NULL if the lock couldn't be created. */
+list_t create_concurrent();
+
+/* ---------------------------------------------------------------------
+*  EnableHashIndex
+*  ---------------------------------------------------------------------
+*  Description:
+*    Adds a hash index to the list_t, so that is_element, index_of,
+*    last_index_of, remove_item and remove_all_items find the items
+*    with a O(1) expected cost instead of comparing them one by one
+*    (index_of and last_index_of still walk the nodes up to the item).
+*    Every edit keeps the index updated: the ones that add, remove or
+*    replace single items update their slots, while the ones that change
+*    all the items or their order (like derive_in_place or
+*    reverse_in_place) rebuild it. Inserting an item before some equal
+*    ones walks the nodes up to the first of them. The items are hashed
+*    with LIST_HASH, if the list type has it, or from their bytes.
+*    Returns TRUE if the list_t already had an index, FALSE if it is
+*    NULL, read-only, concurrent, an array or lock-free stack_t, or if
+*    its type has LIST_EQUALS but not LIST_HASH.
+*  Parameters:
+*    list ---> The list_t to index */
+bool_t enable_hash_index(list_t list);
+
+/* ---------------------------------------------------------------------
+*  DisableHashIndex
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes the hash index of the list_t and releases its memory.
+*    Returns FALSE if the list_t was NULL or it didn't have an index.
+*  Parameters:
+*    list ---> The input list_t */
+bool_t disable_hash_index(list_t list);
+
+/* ---------------------------------------------------------------------
+*  EnableBloomFilter
+*  ---------------------------------------------------------------------
+*  Description:
+*    Adds a bloom filter to the list_t, with 16 bits for each item, so
+*    that is_element, index_of, last_index_of, intersect and except
+*    (without an expression) can skip the search for most of the items
+*    that aren't inside the list_t, reading a single word of memory.
+*    add, add_at, push and the other insertions keep the filter updated;
+*    the removed and replaced items can't be cleared, so the filter is
+*    rebuilt the next time it is used after too many of them.
+*    Works with the hash index too, and hashes the items in the same way.
+*    Returns TRUE if the list_t already had a filter, FALSE if it is
+*    NULL, read-only (like a snapshot or a slice), concurrent, an array
+*    or lock-free stack_t, or if its type has LIST_EQUALS but not
+*    LIST_HASH, just like enable_hash_index.
+*  Parameters:
+*    list ---> The list_t to filter */
+bool_t enable_bloom_filter(list_t list);
+
+/* ---------------------------------------------------------------------
+*  DisableBloomFilter
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes the bloom filter of the list_t and releases its memory.
+*    Returns FALSE if the list_t was NULL or it didn't have a filter.
+*  Parameters:
+*    list ---> The input list_t */
+bool_t disable_bloom_filter(list_t list);
+
+/* ---------------------------------------------------------------------
+*  GetBloomStats
+*  ---------------------------------------------------------------------
+*  Description:
+*    Copies the counters of the bloom filter of the list_t: the items
+*    checked, the ones rejected without a search and the false positives,
+*    the items that passed the filter but weren't inside the list_t.
+*    The counters are kept when the filter is rebuilt or cleared.
+*    Returns FALSE if the list_t was NULL or it didn't have a filter.
+*  Parameters:
+*    list ---> The input list_t
+*    stats ---> A pointer to the counters to fill */
+bool_t get_bloom_stats(list_t list, bloom_stats_t* stats);
+
 /* ---------------------------------------------------------------------
 *  Clear
 *  ---------------------------------------------------------------------
@@ -47,6 +198,9 @@ list_t create();
 *    Removes all the items from the given list_t. It returns TRUE if
 *    the operation was successful or if the list_t was already empty,
 *    FALSE if the list_t was NULL.
+*    The nodes removed by the other functions are kept by the list_t to
+*    be reused later on: this is the function that actually releases
+*    all the memory used by the nodes.
 *  NOTE:
 *    This will ONLY deallocate the list_t nodes: if your T is a pointer
 *    type you'll have to use the for_each function or another custom
@@ -99,6 +253,45 @@ void destroy_sequence(bool_t* result, list_t** pending);
 *    source ---> The input list_t */
 list_t copy(const list_t source);
 
+/* ---------------------------------------------------------------------
+*  Snapshot
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a read-only list_t with the current items of the given one,
+*    in O(1) and without copying them: the two lists share their nodes.
+*    The source list_t can still be edited: the items appended with add,
+*    add_range or add_all are also shared and are not seen by the
+*    snapshot, while the first edit that changes, removes or inserts an
+*    item copies the shared nodes once, until the next snapshot.
+*    A snapshot can be read by a different thread while the source list_t
+*    is being edited, and it stays valid even if the source is destroyed.
+*    It is released with destroy, or with clear (that also makes it an
+*    empty list_t that can be edited). Returns NULL if the list_t was NULL.
+*  Parameters:
+*    list ---> The input list_t */
+list_t snapshot(list_t list);
+
+/* ---------------------------------------------------------------------
+*  Slice
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a read-only list_t with the items of the given one from the
+*    start index up to the end index, excluding it, without copying
+*    them: the slice uses the nodes of the source list_t, so it costs
+*    O(start) to create, or O(1) for a list_t with a contiguous storage,
+*    and then it can be used like any other list_t with the read-only
+*    functions and with get_iterator.
+*    The slice is only valid until the next change of its source, just
+*    like an iterator: after that it looks empty, its iterators are out
+*    of sync and it can only be released with destroy. It must not be
+*    used at all after the source list_t is destroyed.
+*    Returns NULL if the list_t was NULL or the indexes were not valid.
+*  Parameters:
+*    list ---> The input list_t
+*    start ---> The index of the first item of the slice
+*    end ---> The index after the last item of the slice */
+list_t slice(list_t list, int start, int end);
+
 /* ---------------------------------------------------------------------
 *  CreateRandom
 *  ---------------------------------------------------------------------
@@ -114,7 +307,9 @@ list_t copy(const list_t source);
 *    length ---> The numbers of elements to create
 *    min ---> The minimum value inside the range (included)
 *    max ---> The upper value of the desired range (not included) */
+#ifndef LIST_NOT_NUMERIC
 list_t create_random(int length, int min, int max);
+#endif
 
 /* ---------------------------------------------------------------------
 *  CreateFrom
@@ -126,18 +321,79 @@ list_t create_random(int length, int min, int max);
 *    size ---> The length of the source array */
 list_t create_from(T* array, int size);
 
+/* ---------------------------------------------------------------------
+*  CreateFromN
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a new list_t from an array of T elements, allocating all
+*    the nodes with a single block. Unlike create_from, it returns an
+*    empty list_t when size is 0, and NULL only if the array is NULL.
+*  Parameters:
+*    array ---> The input array
+*    size ---> The length of the source array */
+list_t create_from_n(const T* array, int size);
+
 /* ---------------------------------------------------------------------
 *  ToArray
 *  ---------------------------------------------------------------------
 *  Description:
 *    Returns an array with all the elements from the input list_t. Assigns
-*    the length of the list to size, otherwise sets it to -1 if the
-*    list_t was NULL or empty, and returns NULL.
+*    the length of the list to size and returns NULL if the list_t was
+*    empty (size is set to 0) or NULL (size is set to -1).
 *  Parameters:
 *    list ---> The source list_t 
 *    size ---> A pointer to an int to store the size of the array */
 T* to_array(list_t list, int* size);
 
+/* ---------------------------------------------------------------------
+*  CopyTo
+*  ---------------------------------------------------------------------
+*  Description:
+*    Copies the items of the list_t inside a buffer allocated by the
+*    caller, starting from the given index and up to its capacity.
+*    Returns the number of copied items (0 if start is equal to the
+*    length of the list_t), or -1 if the list_t or the buffer were NULL
+*    or if the start index was not valid.
+*  Parameters:
+*    list ---> The source list_t
+*    dst ---> The target buffer
+*    capacity ---> The maximum number of items to copy
+*    start ---> The index of the first item to copy */
+int copy_to(list_t list, T* dst, int capacity, int start);
+
+/* ---------------------------------------------------------------------
+*  CreateAdopting
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a new list_t that uses the given array as its storage,
+*    without copying its items. The list_t takes ownership of the array
+*    and calls free_fn on it when it is cleared or destroyed.
+*    All the read-only functions work directly on the array, while the
+*    first function that edits the list_t moves its items inside new
+*    nodes and releases the array. Returns NULL if the array is NULL.
+*  Example (assuming the array was allocated with malloc):
+*    list_t list = create_adopting(array, size, free);
+*  Parameters:
+*    array ---> The array to use as the list_t storage
+*    size ---> The length of the array
+*    free_fn ---> The function used to release the array, or NULL if
+*    the array will be deallocated by the caller after the list_t */
+list_t create_adopting(T* array, int size, void(*free_fn)(void*));
+
+/* ---------------------------------------------------------------------
+*  ToArrayBorrow
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a read-only pointer to the array used as storage by a list_t
+*    created with create_adopting, and assigns its length to size.
+*    The pointer is valid until the list_t is edited or destroyed.
+*    Returns NULL and sets size to -1 if the list_t is NULL or if it is
+*    not using a contiguous storage: use to_array in that case.
+*  Parameters:
+*    list ---> The source list_t
+*    size ---> A pointer to an int to store the size of the array */
+const T* to_array_borrow(list_t list, int* size);
+
 /* ---------------------------------------------------------------------
 *  IsEmpty
 *  ---------------------------------------------------------------------
@@ -250,6 +506,37 @@ bool_t add_at(const T item, list_t list, int index);
 *    source ---> The source list_t */
 bool_t add_all(list_t target, const list_t source);
 
+/* ---------------------------------------------------------------------
+*  AddRange
+*  ---------------------------------------------------------------------
+*  Description:
+*    Adds all the items inside the given array at the end of the list_t.
+*    The new nodes are allocated with a single block and linked in a
+*    single pass. It returns TRUE if the operation was successful, FALSE
+*    if the list_t or the array were NULL.
+*  Parameters:
+*    array ---> The array with the items to add
+*    size ---> The length of the source array
+*    list ---> The list_t to edit */
+bool_t add_range(const T* array, int size, list_t list);
+
+/* ---------------------------------------------------------------------
+*  InsertRangeAt
+*  ---------------------------------------------------------------------
+*  Description:
+*    Inserts all the items inside the given array in a given position
+*    inside the list_t, so that the first one will have the target index.
+*    If the index is equal to the length of the list_t, the items are
+*    added at its end. It returns TRUE if the operation was successful,
+*    FALSE if the list_t or the array were NULL or if the index was
+*    not valid.
+*  Parameters:
+*    array ---> The array with the items to add
+*    size ---> The length of the source array
+*    list ---> The list_t to edit
+*    index ---> The target index */
+bool_t insert_range_at(const T* array, int size, list_t list, int index);
+
 /* ---------------------------------------------------------------------
 *  Size
 *  ---------------------------------------------------------------------
@@ -284,135 +571,1059 @@ bool_t remove_item(const T item, list_t list);
 bool_t remove_at(list_t list, int index);
 
 /* ---------------------------------------------------------------------
-*  RemoveAllItems
+*  RemoveAllItems
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes all the occurrencies of the given item inside the list_t.
+*    Returns -1 if the list_t was NULL or empty, or if it didn't
+*    contain the element to remove, otherwise it returns the
+*    number of elements that were removed from the list_t.
+*  Parameters:
+*    item ---> The element to remove from the list_t
+*    list ---> The list_t to edit */
+int remove_all_items(const T item, list_t list);
+
+/* ---------------------------------------------------------------------
+*  ReplaceItem
+*  ---------------------------------------------------------------------
+*  Description:
+*    Replaces the first occurrence of the given item inside the list_t.
+*    Returns FALSE if the list_t was NULL or empty, or if the item was
+*    not present inside the list_t.
+*  Parameters:
+*    target ---> The element to remove from the list_t
+*    replacement ---> The element to use as a replacement
+*    list ---> The list_t to edit */
+bool_t replace_item(const T target, const T replacement, list_t list);
+
+/* ---------------------------------------------------------------------
+*  ReplaceAt
+*  ---------------------------------------------------------------------
+*  Description:
+*    Replaces the item in the given position with the new item. Returns
+*    FALSE if the list_t was NULL or empty, of if the index was not valid.
+*  Parameters:
+*    item ---> The raplacement item
+*    list ---> The list_t to edit
+*    index ---> The index of the item that will be replaced */
+bool_t replace_at(const T item, list_t list, int index);
+
+/* ---------------------------------------------------------------------
+*  ReplaceAllItems
+*  ---------------------------------------------------------------------
+*  Description:
+*    Replaces all the occurrencies of the given item inside the list_t.
+*    Returns -1 if the list_t was NULL or empty, or if it didn't
+*    contain the element to replace, otherwise it returns the
+*    number of elements that were replaced inside the list_t..
+*  Parameters:
+*    target ---> The element to remove from the list_t
+*    replacement ---> The element to use when replacing the targets
+*    list ---> The list_t to edit */
+int replace_all_items(const T target, const T replacement, list_t list);
+
+/* ---------------------------------------------------------------------
+*  Swap
+*  ---------------------------------------------------------------------
+*  Description:
+*    Inverts the position of two elements inside a list_t.
+*  Parameters:
+*    list ---> The list_t to edit
+*    index1 ---> The first index of the element to swap
+*    index2 ---> The index of the second element to swap */
+bool_t swap(list_t list, int index1, int index2);
+
+/* ---------------------------------------------------------------------
+*  FormattedPrint
+*  ---------------------------------------------------------------------
+*  Description:
+*    Prints the given list_t using a custom pattern. The function returns
+*    FALSE and prints "NULL list" if the list_t is NULL, it returns FALSE
+*    and prints "Empty list" if the length of the list is 0, otherwise
+*    it displays all the items with the following style:
+*    item1, item2, item3, ..., itemn and then returns TRUE.
+*    The text is written in large blocks, and when the pattern only has
+*    a %d, %i, %u or %f conversion (with an optional precision, like
+*    %.2f) that matches T, the items are converted without parsing the
+*    pattern again for each one of them.
+*  Parameters:
+*    pattern ---> The pattern to use to print each item
+*    list ---> The input list_t */
+bool_t formatted_print(char* pattern, list_t list);
+
+/* ---------------------------------------------------------------------
+*  FormattedPrintTo
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as formatted_print, but it writes the text to the given file.
+*    It also returns FALSE if the file or the pattern were NULL, or if
+*    there was an error while writing.
+*  Parameters:
+*    file ---> The target file
+*    pattern ---> The pattern to use to print each item
+*    list ---> The input list_t */
+bool_t formatted_print_to(FILE* file, const char* pattern, list_t list);
+
+/* ---------------------------------------------------------------------
+*  FormattedPrintBuffer
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as formatted_print, but it writes the text inside a buffer
+*    with the given size, always terminating it with '\0' (like the
+*    snprintf function). Returns the length of the whole text, that is
+*    greater than or equal to size if it was truncated, or -1 if the
+*    pattern was NULL or the buffer was not valid. The buffer can be
+*    NULL when size is 0, to get the required length.
+*  Parameters:
+*    buffer ---> The target buffer
+*    size ---> The size of the buffer
+*    pattern ---> The pattern to use to print each item
+*    list ---> The input list_t */
+int formatted_print_buffer(char* buffer, int size, const char* pattern, list_t list);
+
+/* ---------------------------------------------------------------------
+*  Print
+*  ---------------------------------------------------------------------
+*  Description:
+*    Prints all the items inside the list_t using the same pattern.
+*    The function doesn't print anything if the list_t is empty, and it
+*    doesn't use any kind of formatting between two list_t items.
+*    It returns TRUE if the list contained at least one element.
+*  Parameters:
+*    pattern ---> The pattern to use to print each item
+*    list ---> The input list */
+bool_t print(char* pattern, list_t list);
+
+/* ---------------------------------------------------------------------
+*  PrintTo
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as print, but it writes the items to the given file. It
+*    returns FALSE if the list_t, the file or the pattern were NULL, or
+*    if there was an error while writing.
+*  Parameters:
+*    file ---> The target file
+*    pattern ---> The pattern to use to print each item
+*    list ---> The input list */
+bool_t print_to(FILE* file, const char* pattern, list_t list);
+
+/* ---------------------------------------------------------------------
+*  PrintBuffer
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as print, but it writes the items inside a buffer, just like
+*    the formatted_print_buffer function. Returns the length of the whole
+*    text, or -1 if the list_t or the pattern were NULL or the buffer was
+*    not valid.
+*  Parameters:
+*    buffer ---> The target buffer
+*    size ---> The size of the buffer
+*    pattern ---> The pattern to use to print each item
+*    list ---> The input list */
+int print_buffer(char* buffer, int size, const char* pattern, list_t list);
+
+/* ---------------------------------------------------------------------
+*  ParseList
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a new list_t with the integer values written inside the
+*    given text, divided by the separator char or by new lines. Spaces,
+*    tabs and '\r' chars around the values are ignored, as well as a
+*    final separator. The values are stored in a single array that is
+*    then adopted by the new list_t.
+*    Returns NULL if the buffer was NULL, or if the text was not valid:
+*    in this case, error is set to the offset of the first wrong byte
+*    (or the first byte of a value that doesn't fit inside T), otherwise
+*    it is set to -1.
+*  NOTE:
+*    This function should ONLY be used when T is an integer type.
+*  Parameters:
+*    buffer ---> The text to parse
+*    length ---> The length of the text
+*    separator ---> The char used to divide the values
+*    error ---> Pointer to an int to store the offset of the first
+*    error, it can be NULL */
+#ifndef LIST_NOT_NUMERIC
+list_t parse_list(const char* buffer, int length, char separator, int* error);
+#endif
+
+/* =====================================================================
+*  Serialization
+*  =====================================================================
+*  Description:
+*    Functions used to save a list_t to a binary file and to load it.
+*    The file has a header with the number of items, the size of T,
+*    the byte order of the machine that saved it and a checksum of the
+*    items, followed by the raw block of items.
+*  NOTE:
+*    Just like the create_random function, these functions should ONLY
+*    be used when T is a value type: a pointer type would only save the
+*    addresses and not the values they refer to. */
+
+/* ---------------------------------------------------------------------
+*  SaveList
+*  ---------------------------------------------------------------------
+*  Description:
+*    Writes the list_t to the given file, starting from its current
+*    position. The file must be opened in binary mode. Returns TRUE if
+*    the operation was successful, FALSE if the list_t or the file were
+*    NULL or if there was an error while writing.
+*  Parameters:
+*    list ---> The list_t to save
+*    file ---> The target file */
+bool_t save_list(list_t list, FILE* file);
+
+/* ---------------------------------------------------------------------
+*  LoadList
+*  ---------------------------------------------------------------------
+*  Description:
+*    Reads a list_t saved with the save_list function from the current
+*    position of the given file. The items are read with a single block
+*    that is then adopted by the new list_t, without copying them again.
+*    Returns NULL if the file is NULL, if there was an error while
+*    reading it, if it was saved with a different T size or byte order,
+*    or if the checksum doesn't match its content.
+*  Parameters:
+*    file ---> The source file, opened in binary mode */
+list_t load_list(FILE* file);
+
+/* ---------------------------------------------------------------------
+*  MapList
+*  ---------------------------------------------------------------------
+*  Description:
+*    Maps a file saved with the save_list function in memory and returns
+*    a read-only list_t that reads its items directly from the mapped
+*    file, so that opening it doesn't depend on its size. Pages are only
+*    loaded when they're first read.
+*    The returned list_t can be used with every function that doesn't
+*    edit it (like the LINQ functions, the iterators or copy), while
+*    the functions that would edit it fail. The file is unmapped when
+*    the list_t is cleared or destroyed, and calling clear on it gives
+*    back an empty list_t that can be edited.
+*    Returns NULL if the path is NULL, if the file can't be opened or
+*    mapped, if it was saved with a different T size or byte order or
+*    if it is shorter than the number of items in its header.
+*  NOTE:
+*    The checksum is NOT verified, as that would need to read the whole
+*    file: use load_list if the file could be corrupted. The file must
+*    not be edited while it is mapped.
+*  Parameters:
+*    path ---> The path of the file to map */
+list_t map_list(const char* path);
+
+/* =====================================================================
+*  Streams
+*  =====================================================================
+*  Description:
+*    A list_stream_t reads T records from a file or a file descriptor
+*    and passes them to the given lambda expressions without ever
+*    building a list_t, so it can be used with inputs of any size while
+*    always using the same amount of memory.
+*    The records are read in large chunks by a background thread that
+*    fills a buffer while the previous one is being processed.
+*    Each function continues from the first record that hasn't been
+*    used yet, so a stream can only be scanned once.
+*  NOTE:
+*    The input must only contain raw T values, without the header
+*    written by the save_list function: an incomplete record at the end
+*    of the input is ignored. A read error ends the input instead (the
+*    records of the chunk being read are lost), and then the functions
+*    that reach its end return their failure value, while a read that
+*    is interrupted by a signal is just retried. A list_stream_t must
+*    only be used by a single thread, and the functions that read it
+*    block until the records they need are available. */
+
+/* ---------------------------------------------------------------------
+*  OpenStream
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a list_stream_t that reads the records from the current
+*    position of the given file, and starts reading them. The file is
+*    not closed with the stream. Returns NULL if the file is NULL or if
+*    the stream couldn't be created.
+*  Parameters:
+*    file ---> The source file, opened in binary mode */
+list_stream_t open_stream(FILE* file);
+
+/* ---------------------------------------------------------------------
+*  OpenStreamFd
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as open_stream, but it reads the records from a file descriptor
+*    (like a pipe or a socket). Returns NULL if fd is negative or if the
+*    stream couldn't be created.
+*  Parameters:
+*    fd ---> The source file descriptor */
+list_stream_t open_stream_fd(int fd);
+
+/* ---------------------------------------------------------------------
+*  CloseStream
+*  ---------------------------------------------------------------------
+*  Description:
+*    Stops the background reads and deallocates the list_stream_t, then
+*    sets its pointer to NULL. The remaining records are not read, but
+*    a read that has already started is waited for (with a pipe or a
+*    socket, this means until some data arrives or it gets closed).
+*    Returns FALSE if the stream was NULL, TRUE otherwise.
+*  Parameters:
+*    stream ---> A pointer to the list_stream_t to close */
+bool_t close_stream(list_stream_t* stream);
+
+/* ---------------------------------------------------------------------
+*  StreamCount
+*  ---------------------------------------------------------------------
+*  Description:
+*    Reads all the remaining records and returns the number of them that
+*    satisfy the given condition, or -1 if the stream was NULL or if
+*    there was a read error.
+*  Parameters:
+*    stream ---> The input list_stream_t
+*    expression ---> Selector lambda expression */
+int stream_count(list_stream_t stream, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  StreamSum
+*  ---------------------------------------------------------------------
+*  Description:
+*    Reads all the remaining records and calculates their sum using the
+*    given function to get a numeric value from each of them. Returns 0
+*    if the stream was NULL, if there weren't records left or if there
+*    was a read error.
+*  Parameters:
+*    stream ---> The input list_stream_t
+*    expression ---> ToNumber lambda expression */
+int stream_sum(list_stream_t stream, int(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  StreamFirstOrDefault
+*  ---------------------------------------------------------------------
+*  Description:
+*    Reads the records until it finds one that satisfies the given
+*    condition, and assigns it to result. The following records can
+*    still be read by the next calls. Returns TRUE if a record was
+*    found, FALSE if the stream was NULL, if there was a read error or
+*    if there weren't records left that satisfied the condition.
+*  Parameters:
+*    stream ---> The input list_stream_t
+*    result ---> Pointer to the result T value
+*    expression ---> Selector lambda expression */
+bool_t stream_first_or_default(list_stream_t stream, T* result, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  StreamForEach
+*  ---------------------------------------------------------------------
+*  Description:
+*    Reads all the remaining records and calls the given function for
+*    each one of them. Returns FALSE if the stream was NULL or if there
+*    was a read error, TRUE otherwise.
+*  Parameters:
+*    stream ---> The input list_stream_t
+*    expression ---> The lambda expression to call */
+bool_t stream_for_each(list_stream_t stream, void(*expression)(item_arg_t));
+
+/* =====================================================================
+*  Frozen lists
+*  =====================================================================
+*  Description:
+*    A frozen_list_t is an immutable and compressed copy of a list_t.
+*    The items are divided in blocks of 128: each block stores its first
+*    item and then the difference between each item and the previous one
+*    using as few bytes as possible, so that a sorted list_t with small
+*    gaps between its items only needs 1 or 2 bytes for each item.
+*    Each block also stores its minimum and maximum item, so that the
+*    is_element function can skip the blocks that can't contain an item.
+*  NOTE:
+*    These functions should ONLY be used when T is an integer type. */
+#ifndef LIST_NOT_NUMERIC
+
+/* ---------------------------------------------------------------------
+*  Freeze
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a frozen_list_t with the items of the given list_t, that is
+*    not modified. Returns NULL if the list_t was NULL.
+*  Parameters:
+*    list ---> The list_t to freeze */
+frozen_list_t freeze(list_t list);
+
+/* ---------------------------------------------------------------------
+*  Thaw
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a new list_t with the items of a frozen_list_t, that can be
+*    edited again. Returns NULL if the frozen_list_t was NULL.
+*  Parameters:
+*    frozen ---> The frozen_list_t to thaw */
+list_t thaw(frozen_list_t frozen);
+
+/* ---------------------------------------------------------------------
+*  DestroyFrozen
+*  ---------------------------------------------------------------------
+*  Description:
+*    Deallocates a frozen_list_t and sets its pointer to NULL. Returns
+*    FALSE if the frozen_list_t was already NULL, TRUE otherwise.
+*  Parameters:
+*    frozen ---> A pointer to the frozen_list_t to deallocate */
+bool_t destroy_frozen(frozen_list_t* frozen);
+
+/* ---------------------------------------------------------------------
+*  FrozenSize
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns the number of items inside a frozen_list_t, or -1 if it
+*    was NULL.
+*  Parameters:
+*    frozen ---> The input frozen_list_t */
+int frozen_size(frozen_list_t frozen);
+
+/* ---------------------------------------------------------------------
+*  FrozenBytes
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns the number of bytes used by a frozen_list_t, or 0 if it
+*    was NULL.
+*  Parameters:
+*    frozen ---> The input frozen_list_t */
+size_t frozen_bytes(frozen_list_t frozen);
+
+/* ---------------------------------------------------------------------
+*  FrozenToArray
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the to_array function, but it works on a frozen_list_t.
+*  Parameters:
+*    frozen ---> The source frozen_list_t
+*    size ---> A pointer to an int to store the size of the array */
+T* frozen_to_array(frozen_list_t frozen, int* size);
+
+/* ---------------------------------------------------------------------
+*  FrozenIsElement
+*  ---------------------------------------------------------------------
+*  Description:
+*    Checks if an item is inside a frozen_list_t, decoding only the
+*    blocks that could contain it (just one, if the items are sorted).
+*    Returns FALSE if the frozen_list_t was NULL.
+*  Parameters:
+*    item ---> The item to look for
+*    frozen ---> The input frozen_list_t */
+bool_t frozen_is_element(const T item, frozen_list_t frozen);
+
+/* ---------------------------------------------------------------------
+*  FrozenForEach
+*  ---------------------------------------------------------------------
+*  Description:
+*    Decodes the items one block at a time and calls the given function
+*    for each one of them. Returns FALSE if the frozen_list_t was NULL or
+*    empty, TRUE otherwise.
+*  Parameters:
+*    frozen ---> The input frozen_list_t
+*    expression ---> The lambda expression to call */
+bool_t frozen_for_each(frozen_list_t frozen, void(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  FrozenCount
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the count function, but it works on a frozen_list_t.
+*  Parameters:
+*    frozen ---> The input frozen_list_t
+*    expression ---> Selector lambda expression */
+int frozen_count(frozen_list_t frozen, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  FrozenSum
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the sum function, but it works on a frozen_list_t.
+*  Parameters:
+*    frozen ---> The input frozen_list_t
+*    expression ---> ToNumber lambda expression */
+int frozen_sum(frozen_list_t frozen, int(*expression)(item_arg_t));
+#endif
+
+/* =====================================================================
+*  Persistent lists
+*  =====================================================================
+*  Description:
+*    A persistent_list_t is an immutable version of a list: the functions
+*    that edit it return a new version and leave the original one as it
+*    is. The items are stored inside a balanced tree, and each new version
+*    only copies the O(log n) tree nodes on the path to the edited item,
+*    sharing all the other ones with the previous version.
+*    Getting, adding, inserting, replacing or removing an item at any
+*    index has a O(log n) cost.
+*  NOTE:
+*    Each version must be deallocated with destroy_persistent, the nodes
+*    shared with other versions are only released with the last one.
+*    The versions can be read and edited by different threads at the
+*    same time, as they never change. */
+
+/* ---------------------------------------------------------------------
+*  CreatePersistent
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates an empty persistent_list_t. */
+persistent_list_t create_persistent();
+
+/* ---------------------------------------------------------------------
+*  ToPersistent
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a persistent_list_t with the items of the given list_t, in
+*    O(n). Returns NULL if the list_t was NULL.
+*  Parameters:
+*    list ---> The source list_t */
+persistent_list_t to_persistent(list_t list);
+
+/* ---------------------------------------------------------------------
+*  PersistentToList
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates a new list_t with the items of a persistent_list_t, so that
+*    it can be used with all the other functions. Returns NULL if the
+*    persistent_list_t was NULL.
+*  Parameters:
+*    persistent ---> The source persistent_list_t */
+list_t persistent_to_list(persistent_list_t persistent);
+
+/* ---------------------------------------------------------------------
+*  DestroyPersistent
+*  ---------------------------------------------------------------------
+*  Description:
+*    Deallocates a version of a persistent_list_t and sets its pointer to
+*    NULL. Returns FALSE if it was already NULL, TRUE otherwise.
+*  Parameters:
+*    persistent ---> A pointer to the persistent_list_t to deallocate */
+bool_t destroy_persistent(persistent_list_t* persistent);
+
+/* ---------------------------------------------------------------------
+*  PersistentSize
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns the number of items inside a persistent_list_t, or -1 if it
+*    was NULL.
+*  Parameters:
+*    persistent ---> The input persistent_list_t */
+int persistent_size(persistent_list_t persistent);
+
+/* ---------------------------------------------------------------------
+*  PersistentGet
+*  ---------------------------------------------------------------------
+*  Description:
+*    Assigns to result the item in the given position. Returns FALSE if
+*    the persistent_list_t was NULL or the index was not valid.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    index ---> The index of the item
+*    result ---> Pointer to the result T value */
+bool_t persistent_get(persistent_list_t persistent, int index, T* result);
+
+/* ---------------------------------------------------------------------
+*  PersistentAdd
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a new version with the item added at the end of the list.
+*    Returns NULL if the persistent_list_t was NULL.
+*  Parameters:
+*    item ---> The item to add
+*    persistent ---> The source version */
+persistent_list_t persistent_add(const T item, persistent_list_t persistent);
+
+/* ---------------------------------------------------------------------
+*  PersistentAddAt
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a new version with the item inserted in the given position
+*    (that can also be equal to the length of the list). Returns NULL if
+*    the persistent_list_t was NULL or the index was not valid.
+*  Parameters:
+*    item ---> The item to add
+*    persistent ---> The source version
+*    index ---> The position of the new item */
+persistent_list_t persistent_add_at(const T item, persistent_list_t persistent, int index);
+
+/* ---------------------------------------------------------------------
+*  PersistentReplaceAt
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a new version where the item in the given position has been
+*    replaced. Returns NULL if the persistent_list_t was NULL or the index
+*    was not valid.
+*  Parameters:
+*    item ---> The new item
+*    persistent ---> The source version
+*    index ---> The position of the item to replace */
+persistent_list_t persistent_replace_at(const T item, persistent_list_t persistent, int index);
+
+/* ---------------------------------------------------------------------
+*  PersistentRemoveAt
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a new version without the item in the given position.
+*    Returns NULL if the persistent_list_t was NULL or the index was not
+*    valid.
+*  Parameters:
+*    persistent ---> The source version
+*    index ---> The position of the item to remove */
+persistent_list_t persistent_remove_at(persistent_list_t persistent, int index);
+
+/* ---------------------------------------------------------------------
+*  PersistentToArray
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the to_array function, but it works on a persistent_list_t.
+*  Parameters:
+*    persistent ---> The source persistent_list_t
+*    size ---> A pointer to an int to store the size of the array */
+T* persistent_to_array(persistent_list_t persistent, int* size);
+
+/* ---------------------------------------------------------------------
+*  PersistentIsElement
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the is_element function, but it works on a
+*    persistent_list_t.
+*  Parameters:
+*    item ---> The item to look for
+*    persistent ---> The input persistent_list_t */
+bool_t persistent_is_element(const T item, persistent_list_t persistent);
+
+/* ---------------------------------------------------------------------
+*  PersistentIndexOf
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the index_of function, but it works on a persistent_list_t.
+*  Parameters:
+*    item ---> The item to look for
+*    persistent ---> The input persistent_list_t */
+int persistent_index_of(const T item, persistent_list_t persistent);
+
+/* ---------------------------------------------------------------------
+*  PersistentForEach
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the for_each function, but it works on a persistent_list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    expression ---> The lambda expression to call */
+bool_t persistent_for_each(persistent_list_t persistent, void(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  PersistentFirstOrDefault
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the first_or_default function, but it works on a
+*    persistent_list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    result ---> Pointer to the result T value
+*    expression ---> Selector lambda expression */
+bool_t persistent_first_or_default(persistent_list_t persistent, T* result, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  PersistentCount
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the count function, but it works on a persistent_list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    expression ---> Selector lambda expression */
+int persistent_count(persistent_list_t persistent, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  PersistentAny
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the any function, but it works on a persistent_list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    expression ---> Selector lambda expression */
+bool_t persistent_any(persistent_list_t persistent, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  PersistentAll
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the all function, but it works on a persistent_list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    expression ---> Selector lambda expression */
+bool_t persistent_all(persistent_list_t persistent, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  PersistentWhere
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the where function, but it works on a persistent_list_t and
+*    returns a new list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    expression ---> Selector lambda expression */
+list_t persistent_where(persistent_list_t persistent, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  PersistentSum
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as the sum function, but it works on a persistent_list_t.
+*  Parameters:
+*    persistent ---> The input persistent_list_t
+*    expression ---> ToNumber lambda expression */
+int persistent_sum(persistent_list_t persistent, int(*expression)(item_arg_t));
+
+/* =====================================================================
+*  stack_t
+*  =====================================================================
+*  Description:
+*    Functions used to manage a stack_t.
+*  NOTE:
+*    The Push and Pop functions work with SIDE EFFECT. */
+
+/* ---------------------------------------------------------------------
+*  CreateLockFreeStack
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates an empty stack_t that different threads can use at the same
+*    time with push, pop and peek, without any lock: each operation is a
+*    single atomic compare and swap on the top of the stack_t, and each
+*    thread keeps a small cache of free nodes, so that the nodes are
+*    rarely shared between the threads and never released before the
+*    stack_t is destroyed. The other functions see it as an empty,
+*    read-only list_t. It must be released with destroy (or clear, that
+*    also turns it into a normal empty stack_t) after all the threads are
+*    done with it. Returns NULL if the stack_t couldn't be created. */
+stack_t create_lock_free_stack();
+
+/* ---------------------------------------------------------------------
+*  CreateArrayStack
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates an empty stack_t that stores its items inside an array,
+*    instead of a node for each item: push and pop just write or read the
+*    next position of the array, that is reallocated with twice its
+*    capacity when it is full, and the stack_t can be read by all the
+*    other functions like any other list_t, from the top item.
+*    The first function (other than push and pop) that edits the
+*    stack_t moves its items inside new nodes, like for create_adopting.
+*    Returns NULL if the capacity was negative or couldn't be allocated.
+*  Parameters:
+*    capacity ---> The number of items to allocate in advance (can be 0) */
+stack_t create_array_stack(int capacity);
+
+/* ---------------------------------------------------------------------
+*  Reserve
+*  ---------------------------------------------------------------------
+*  Description:
+*    Makes sure an array stack_t can hold at least the given number of
+*    items before it has to grow again. Returns FALSE if the stack_t was
+*    NULL, if it doesn't use an array or if the memory couldn't be
+*    allocated.
+*  Parameters:
+*    stack ---> The array stack_t to edit
+*    capacity ---> The number of items the stack_t should be able to hold */
+bool_t reserve(stack_t stack, int capacity);
+
+/* ---------------------------------------------------------------------
+*  Push
+*  ---------------------------------------------------------------------
+*  Description:
+*    Adds an element to the top of the stack_t. Returns TRUE if the
+*    operation was successful, FALSE if the stack_t was NULL or empty.
+*  Parameters:
+*    item ---> The item to add
+*    stack ---> The stack_t to edit */
+bool_t push(const T item, stack_t stack);
+
+/* ---------------------------------------------------------------------
+*  Pop
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes the top element from the stack_t and assigns it to result,
+*    then returns TRUE. If the stack_t is NULL or empty, it returns FALSE.
+*  Parameters:
+*    stack ---> The stack_t to edit 
+*     result ---> Pointer to the result T value */
+bool_t pop(stack_t stack, T* result);
+
+/* ---------------------------------------------------------------------
+*  Peek
+*  ---------------------------------------------------------------------
+*  Description:
+*    Assigns to result the top element without removing it from the stack_t.
+*    Returns FALSE if the stack is NULL or empty.
+*  Parameters:
+*    stack ---> The input stack_t 
+*    result ---> Pointer to the result T value */
+bool_t peek(stack_t stack, T* result);
+
+/* =====================================================================
+*  queue_t
+*  =====================================================================
+*  Description:
+*    Functions used to manage a queue_t: a FIFO queue with a fixed
+*    capacity, stored in a ring buffer allocated once. Different threads
+*    can enqueue and dequeue items at the same time without any lock.
+*  NOTE:
+*    The Enqueue and Dequeue functions work with SIDE EFFECT. */
+
+/* ---------------------------------------------------------------------
+*  CreateQueue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates an empty queue_t that any number of threads can use at the
+*    same time, both to enqueue and to dequeue items. The capacity is
+*    rounded up to the next power of 2. Returns NULL if the capacity
+*    was not valid or if the queue_t couldn't be created.
+*  Parameters:
+*    capacity ---> The maximum number of items in the queue_t */
+queue_t create_queue(int capacity);
+
+/* ---------------------------------------------------------------------
+*  CreateSPSCQueue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Creates an empty queue_t that is faster than the one returned by
+*    create_queue, but that can only be used by a single thread that
+*    enqueues the items and a single thread that dequeues them (that can
+*    be the same one). The capacity is rounded up to the next power of 2.
+*    Returns NULL if the capacity was not valid or if the queue_t
+*    couldn't be created.
+*  Parameters:
+*    capacity ---> The maximum number of items in the queue_t */
+queue_t create_spsc_queue(int capacity);
+
+/* ---------------------------------------------------------------------
+*  DestroyQueue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Deallocates a queue_t and sets its pointer to NULL, once no other
+*    thread is using it. Returns FALSE if the queue_t was already NULL.
+*  Parameters:
+*    queue ---> A pointer to the queue_t to destroy */
+bool_t destroy_queue(queue_t* queue);
+
+/* ---------------------------------------------------------------------
+*  QueueSize
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns the number of items in a queue_t, or -1 if it was NULL.
+*    The value can already be different when the function returns, if
+*    other threads are using the queue_t.
+*  Parameters:
+*    queue ---> The input queue_t */
+int queue_size(queue_t queue);
+
+/* ---------------------------------------------------------------------
+*  Enqueue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Adds an item at the end of a queue_t, without waiting. Returns TRUE
+*    if the operation was successful, FALSE if the queue_t was NULL or full.
+*  Parameters:
+*    item ---> The item to add
+*    queue ---> The queue_t to edit */
+bool_t enqueue(const T item, queue_t queue);
+
+/* ---------------------------------------------------------------------
+*  Dequeue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes the first item from a queue_t and assigns it to result,
+*    waiting for another thread to enqueue an item if the queue_t is
+*    empty. Returns FALSE only if the queue_t was NULL.
+*  Parameters:
+*    queue ---> The queue_t to edit
+*    result ---> Pointer to the result T value */
+bool_t dequeue(queue_t queue, T* result);
+
+/* ---------------------------------------------------------------------
+*  TryDequeue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes the first item from a queue_t and assigns it to result,
+*    without waiting. Returns FALSE if the queue_t was NULL or empty.
+*  Parameters:
+*    queue ---> The queue_t to edit
+*    result ---> Pointer to the result T value */
+bool_t try_dequeue(queue_t queue, T* result);
+
+/* ---------------------------------------------------------------------
+*  EnqueueRange
 *  ---------------------------------------------------------------------
 *  Description:
-*    Removes all the occurrencies of the given item inside the list_t.
-*    Returns -1 if the list_t was NULL or empty, or if it didn't
-*    contain the element to remove, otherwise it returns the
-*    number of elements that were removed from the list_t.
+*    Adds the items of an array at the end of a queue_t, reserving
+*    their positions with a single atomic operation: the items enqueued
+*    by another thread at the same time can't be mixed with them.
+*    If the queue_t doesn't have room for all of them, it only adds the
+*    first ones. Returns the number of items added, or -1 if the
+*    queue_t or the array were NULL.
 *  Parameters:
-*    item ---> The element to remove from the list_t
-*    list ---> The list_t to edit */
-int remove_all_items(const T item, list_t list);
+*    array ---> The items to add
+*    size ---> The number of items inside the array
+*    queue ---> The queue_t to edit */
+int enqueue_range(const T* array, int size, queue_t queue);
 
 /* ---------------------------------------------------------------------
-*  ReplaceItem
+*  DequeueRange
 *  ---------------------------------------------------------------------
 *  Description:
-*    Replaces the first occurrence of the given item inside the list_t.
-*    Returns FALSE if the list_t was NULL or empty, or if the item was
-*    not present inside the list_t.
+*    Removes up to capacity items from the beginning of a queue_t, in
+*    order, and copies them into a buffer, without waiting. Returns the
+*    number of items removed, or -1 if the queue_t or the buffer were NULL.
 *  Parameters:
-*    target ---> The element to remove from the list_t
-*    replacement ---> The element to use as a replacement
-*    list ---> The list_t to edit */
-bool_t replace_item(const T target, const T replacement, list_t list);
+*    queue ---> The queue_t to edit
+*    buffer ---> The destination buffer
+*    capacity ---> The maximum number of items to remove */
+int dequeue_range(queue_t queue, T* buffer, int capacity);
+
+/* =====================================================================
+*  append_list_t
+*  =====================================================================
+*  Description:
+*    Functions used to manage an append_list_t: a list that any number
+*    of threads can fill at the same time without any lock, and that is
+*    turned into a list_t once all of them are done.
+*  NOTE:
+*    The items of an append_list_t can't be read until it is sealed. */
 
 /* ---------------------------------------------------------------------
-*  ReplaceAt
+*  CreateAppendList
 *  ---------------------------------------------------------------------
 *  Description:
-*    Replaces the item in the given position with the new item. Returns
-*    FALSE if the list_t was NULL or empty, of if the index was not valid.
-*  Parameters:
-*    item ---> The raplacement item
-*    list ---> The list_t to edit
-*    index ---> The index of the item that will be replaced */
-bool_t replace_at(const T item, list_t list, int index);
+*    Creates an empty append_list_t, or returns NULL if it couldn't
+*    be created. */
+append_list_t create_append_list();
 
 /* ---------------------------------------------------------------------
-*  ReplaceAllItems
+*  DestroyAppendList
 *  ---------------------------------------------------------------------
 *  Description:
-*    Replaces all the occurrencies of the given item inside the list_t.
-*    Returns -1 if the list_t was NULL or empty, or if it didn't
-*    contain the element to replace, otherwise it returns the
-*    number of elements that were replaced inside the list_t..
+*    Deallocates an append_list_t with its items and sets its pointer to
+*    NULL, once no other thread is using it. Returns FALSE if the
+*    append_list_t was already NULL.
 *  Parameters:
-*    target ---> The element to remove from the list_t
-*    replacement ---> The element to use when replacing the targets
-*    list ---> The list_t to edit */
-int replace_all_items(const T target, const T replacement, list_t list);
+*    list ---> A pointer to the append_list_t to destroy */
+bool_t destroy_append_list(append_list_t* list);
 
 /* ---------------------------------------------------------------------
-*  Swap
+*  Append
 *  ---------------------------------------------------------------------
 *  Description:
-*    Inverts the position of two elements inside a list_t.
+*    Adds an item to an append_list_t. Returns TRUE if the operation was
+*    successful, FALSE if the append_list_t was NULL or if there wasn't
+*    enough memory.
 *  Parameters:
-*    list ---> The list_t to edit
-*    index1 ---> The first index of the element to swap
-*    index2 ---> The index of the second element to swap */
-bool_t swap(list_t list, int index1, int index2);
+*    item ---> The item to add
+*    list ---> The append_list_t to edit */
+bool_t append(const T item, append_list_t list);
 
 /* ---------------------------------------------------------------------
-*  FormattedPrint
+*  AppendRange
 *  ---------------------------------------------------------------------
 *  Description:
-*    Prints the given list_t using a custom pattern. The function returns
-*    FALSE and prints "NULL list" if the list_t is NULL, it returns FALSE
-*    and prints "Empty list" if the length of the list is 0, otherwise
-*    it displays all the items with the following style:
-*    item1, item2, item3, ..., itemn and then returns TRUE.
+*    Adds the items of an array to an append_list_t, reserving their
+*    positions with a single atomic operation: the items added by
+*    another thread at the same time can't be mixed with them.
+*    Returns the number of items added, or -1 if the append_list_t or
+*    the array were NULL or if there wasn't enough memory.
 *  Parameters:
-*    pattern ---> The pattern to use to print each item
-*    list ---> The input list_t */
-bool_t formatted_print(char* pattern, list_t list);
+*    array ---> The items to add
+*    size ---> The number of items inside the array
+*    list ---> The append_list_t to edit */
+int append_range(const T* array, int size, append_list_t list);
 
 /* ---------------------------------------------------------------------
-*  Print
+*  Seal
 *  ---------------------------------------------------------------------
 *  Description:
-*    Prints all the items inside the list_t using the same pattern.
-*    The function doesn't print anything if the list_t is empty, and it
-*    doesn't use any kind of formatting between two list_t items.
-*    It returns TRUE if the list contained at least one element.
+*    Returns a list_t with the items of an append_list_t, that is then
+*    deallocated and its pointer set to NULL. The threads that added the
+*    items must be done, and their work visible to the current thread
+*    (for example after pthread_join or a barrier). The items added with
+*    a single AppendRange call are kept together, in order, while the
+*    items added by different threads can be in any order.
+*    Returns NULL, leaving the append_list_t untouched, if it was NULL,
+*    if it couldn't store one of the items or if there wasn't enough memory.
 *  Parameters:
-*    pattern ---> The pattern to use to print each item
-*    list ---> The input list */
-bool_t print(char* pattern, list_t list);
+*    list ---> A pointer to the append_list_t to seal */
+list_t seal(append_list_t* list);
 
 /* =====================================================================
-*  stack_t
+*  rcu_list_t
 *  =====================================================================
 *  Description:
-*    Functions used to manage a stack_t.
+*    Functions used to manage an rcu_list_t: a list that is read by many
+*    threads and rarely edited (read-copy-update). The readers use the
+*    current version of the list, a read-only list_t that never changes,
+*    without any lock; a writer edits a copy and replaces the current
+*    version with it. An old version is only deallocated once all the
+*    readers that could be using it are done.
 *  NOTE:
-*    The Push and Pop functions work with SIDE EFFECT. */
+*    A thread can't destroy or edit a version of an rcu_list_t, and it
+*    can only use it between BeginRCURead and EndRCURead. */
 
 /* ---------------------------------------------------------------------
-*  Push
+*  CreateRCUList
 *  ---------------------------------------------------------------------
 *  Description:
-*    Adds an element to the top of the stack_t. Returns TRUE if the
-*    operation was successful, FALSE if the stack_t was NULL or empty.
+*    Creates an rcu_list_t whose first version has the items of a list_t
+*    (or no items, if it is NULL). Returns NULL if the rcu_list_t
+*    couldn't be created.
 *  Parameters:
-*    item ---> The item to add
-*    stack ---> The stack_t to edit */
-bool_t push(const T item, stack_t stack);
+*    list ---> The list_t with the initial items */
+rcu_list_t create_rcu_list(list_t list);
 
 /* ---------------------------------------------------------------------
-*  Pop
+*  DestroyRCUList
 *  ---------------------------------------------------------------------
 *  Description:
-*    Removes the top element from the stack_t and assigns it to result,
-*    then returns TRUE. If the stack_t is NULL or empty, it returns FALSE.
+*    Deallocates an rcu_list_t with all its versions and sets its pointer
+*    to NULL, once no other thread is using it. Returns FALSE if the
+*    rcu_list_t was already NULL.
 *  Parameters:
-*    stack ---> The stack_t to edit 
-*     result ---> Pointer to the result T value */
-bool_t pop(stack_t stack, T* result);
+*    list ---> A pointer to the rcu_list_t to destroy */
+bool_t destroy_rcu_list(rcu_list_t* list);
 
 /* ---------------------------------------------------------------------
-*  Peek
+*  BeginRCURead
 *  ---------------------------------------------------------------------
 *  Description:
-*    Assigns to result the top element without removing it from the stack_t.
-*    Returns FALSE if the stack is NULL or empty.
+*    Returns the current version of an rcu_list_t, that the thread can
+*    read with any function that doesn't edit a list_t until it calls
+*    EndRCURead, or NULL if the rcu_list_t was NULL. The read functions
+*    don't use any lock or atomic operation on this list_t: reading it
+*    costs the same as reading a list_t used by a single thread.
+*    The calls can be nested, each one must be paired with EndRCURead.
 *  Parameters:
-*    stack ---> The input stack_t 
-*    result ---> Pointer to the result T value */
-bool_t peek(stack_t stack, T* result);
+*    list ---> The rcu_list_t to read */
+list_t begin_rcu_read(rcu_list_t list);
+
+/* ---------------------------------------------------------------------
+*  EndRCURead
+*  ---------------------------------------------------------------------
+*  Description:
+*    Marks the end of a read started with BeginRCURead: the version of
+*    the rcu_list_t it returned can't be used anymore.
+*  Parameters:
+*    list ---> The rcu_list_t that was read */
+void end_rcu_read(rcu_list_t list);
+
+/* ---------------------------------------------------------------------
+*  UpdateRCUList
+*  ---------------------------------------------------------------------
+*  Description:
+*    Calls a function with a copy of the current version of an rcu_list_t,
+*    that it can edit, and makes the copy the new current version, unless
+*    the function returns FALSE. Only one thread at a time can update the
+*    rcu_list_t, the readers can keep reading it in the meantime.
+*    The old versions nobody can be reading are deallocated. Returns TRUE
+*    if the new version was published, FALSE if the rcu_list_t or the
+*    function were NULL, if the function returned FALSE or if there
+*    wasn't enough memory.
+*  Parameters:
+*    list ---> The rcu_list_t to edit
+*    update ---> The function that edits the copy */
+bool_t update_rcu_list(rcu_list_t list, bool_t(*update)(list_t));
 
 /* =====================================================================
 *  LINQ
@@ -425,6 +1636,9 @@ bool_t peek(stack_t stack, T* result);
 *    is possible to create a standard function and pass a pointer to
 *    it, or to create a lambda expression using the macro defined 
 *    inside this header file.
+*    The parameters of these expressions have the item_arg_t type: the
+*    examples below pass the items by value, with LIST_BY_POINTER
+*    they get a const T* instead (item1->key, item2->key, ...).
 *  NOTE:
 *    All the functions inside this section are FUNCTIONAL and do NOT 
 *    edit the input list_ts or their elements. */
@@ -451,7 +1665,7 @@ __extension__                         \
 *        else return !(number % 2);
 *    }) */
 #define selector(var_name, func_body) \
-lambda(bool_t, (T var_name) func_body)
+lambda(bool_t, (item_arg_t var_name) func_body)
 
 /* ---------------------------------------------------------------------
 *  Block
@@ -461,7 +1675,7 @@ lambda(bool_t, (T var_name) func_body)
 *    performs some operations and returns void.
 *  Example (assuming T is int):
 *    block(item, { printf("%d ", item); }) */
-#define block(var_name, func_body) lambda(void, (T var_name) func_body)
+#define block(var_name, func_body) lambda(void, (item_arg_t var_name) func_body)
 
 /* ---------------------------------------------------------------------
 *  Zipper
@@ -476,7 +1690,7 @@ lambda(bool_t, (T var_name) func_body)
 *        return item2 - item1;
 *    }) */
 #define zipper(var1_name, var2_name, func_body) \
-lambda(T, (T var1_name, T var2_name) func_body) \
+lambda(T, (item_arg_t var1_name, item_arg_t var2_name) func_body) \
 
 /* ---------------------------------------------------------------------
 *  EqualityTester
@@ -486,15 +1700,18 @@ lambda(T, (T var1_name, T var2_name) func_body) \
 *    returns true if those arguments are equal, false otherwise.
 *  Example:
 *    equalityTester(number1, number2, { return number1 == number2; }) */
-#define equalityTester(var1_name, var2_name, func_body) \
-lambda(bool_t, (T var1_name, T var2_name) func_body)      \
+#define equalityTester(var1_name, var2_name, func_body)                \
+lambda(bool_t, (item_arg_t var1_name, item_arg_t var2_name) func_body) \
 
 /* ---------------------------------------------------------------------
 *  Comparation
 *  ---------------------------------------------------------------------
 *  Description:
 *    The type returned by a Comparator lambda expression */
+#ifndef LIST_T_COMPARATION
+#define LIST_T_COMPARATION
 typedef enum { EQUAL, GREATER, LOWER } comparation;
+#endif
 
 /* ---------------------------------------------------------------------
 *  Comparator
@@ -512,8 +1729,8 @@ typedef enum { EQUAL, GREATER, LOWER } comparation;
 *        else if (number2 > number1) return LOWER;
 *        return EQUAL;
 *    }) */
-#define comparator(var1_name, var2_name, func_body)       \
-lambda(comparation, (T var1_name, T var2_name) func_body) \
+#define comparator(var1_name, var2_name, func_body)                         \
+lambda(comparation, (item_arg_t var1_name, item_arg_t var2_name) func_body) \
 
 /* ---------------------------------------------------------------------
 *  ToNumber
@@ -529,7 +1746,7 @@ lambda(comparation, (T var1_name, T var2_name) func_body) \
 *        return item - start;
 *    }) */
 #define toNumber(var_name, func_body) \
-lambda(int, (T var_name) func_body)
+lambda(int, (item_arg_t var_name) func_body)
 
 /* ---------------------------------------------------------------------
 *  Deriver
@@ -542,7 +1759,20 @@ lambda(int, (T var_name) func_body)
 *    {
 *        return roundf(item);
 *    }) */
-#define deriver(var_name, func_body) lambda(T, (T var_name) func_body)
+#define deriver(var_name, func_body) lambda(T, (item_arg_t var_name) func_body)
+
+/* ---------------------------------------------------------------------
+*  Hasher
+*  ---------------------------------------------------------------------
+*  Description:
+*    Represents a function that takes a single argument and returns
+*    its hash: the equal arguments must have the same hash.
+*  Example (assuming T is a struct with an int id):
+*    hasher(item,
+*    {
+*        return (size_t)item.id;
+*    }) */
+#define hasher(var_name, func_body) lambda(size_t, (item_arg_t var_name) func_body)
 
 /* ---------------------------------------------------------------------
 *  FirstOrDefault
@@ -555,7 +1785,7 @@ lambda(int, (T var_name) func_body)
 *    list ---> The input list_t
 *    result ---> Pointer to the result T value
 *    expression ---> Selector lambda expression */
-bool_t first_or_default(list_t list, T* result, bool_t(*expression)(T));
+bool_t first_or_default(list_t list, T* result, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  LastOrDefault
@@ -568,7 +1798,7 @@ bool_t first_or_default(list_t list, T* result, bool_t(*expression)(T));
 *    list ---> The input list_t
 *    result ---> Pointer to the result T value
 *    expression ---> Selector lambda expression */
-bool_t last_or_default(list_t list, T* result, bool_t(*expression)(T));
+bool_t last_or_default(list_t list, T* result, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Count
@@ -579,7 +1809,7 @@ bool_t last_or_default(list_t list, T* result, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-int count(list_t list, bool_t(*expression)(T));
+int count(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  FirstIndexWhere
@@ -591,7 +1821,7 @@ int count(list_t list, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-int first_index_where(list_t list, bool_t(*expression)(T));
+int first_index_where(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  LastIndexWhere
@@ -603,7 +1833,7 @@ int first_index_where(list_t list, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-int last_index_where(list_t list, bool_t(*expression)(T));
+int last_index_where(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Where
@@ -615,7 +1845,7 @@ int last_index_where(list_t list, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-list_t where(list_t list, bool_t(*expression)(T));
+list_t where(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  TakeWhile
@@ -627,7 +1857,7 @@ list_t where(list_t list, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-list_t take_while(list_t list, bool_t(*expression)(T));
+list_t take_while(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  TakeRange
@@ -635,6 +1865,7 @@ list_t take_while(list_t list, bool_t(*expression)(T));
 *  Description:
 *    Returns a list_t of all the items from the input list that
 *    are located between the two given indexes, including them.
+*    Use slice to read the same items without copying them.
 *    Returns NULL if the list_t was NULL or if the indexes were not valid.
 *  Parameters:
 *    list ---> The input list_t
@@ -667,7 +1898,7 @@ list_t concat(list_t list1, list_t list2);
 *    list1 ---> The first list_t to combine
 *    list2 ---> Should have the same number of items of the first one
 *    expression ---> Zipper lambda expression */
-list_t zip(list_t list1, list_t list2, T(*expression)(T, T));
+list_t zip(list_t list1, list_t list2, T(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Any
@@ -678,7 +1909,7 @@ list_t zip(list_t list1, list_t list2, T(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-bool_t any(list_t list, bool_t(*expression)(T));
+bool_t any(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  All
@@ -689,7 +1920,7 @@ bool_t any(list_t list, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-bool_t all(list_t list, bool_t(*expression)(T));
+bool_t all(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Skip
@@ -697,6 +1928,7 @@ bool_t all(list_t list, bool_t(*expression)(T));
 *  Description:
 *    Skips the first n elements from the input list_t, then
 *    creates a new list_t with the remaining elements and returns it.
+*    Use slice to read the same items without copying them.
 *  Parameters:
 *    list ---> The input list_t
 *    count ---> The number of list_t items to skip */
@@ -711,7 +1943,7 @@ list_t skip(list_t list, int count);
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-list_t skip_while(list_t list, bool_t(*expression)(T));
+list_t skip_while(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  ForEach
@@ -723,7 +1955,7 @@ list_t skip_while(list_t list, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Block lambda expression */
-bool_t for_each(list_t list, void(*expression)(T));
+bool_t for_each(list_t list, void(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  InverseForEach
@@ -736,7 +1968,7 @@ bool_t for_each(list_t list, void(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Block lambda expression */
-bool_t inverse_for_each(list_t list, void(*expression)(T));
+bool_t inverse_for_each(list_t list, void(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Join
@@ -748,7 +1980,7 @@ bool_t inverse_for_each(list_t list, void(*expression)(T));
 *    list1 ---> The first input list_t
 *    list2 ---> The second list_t, it can have an arbitrary length
 *    expression ---> EqualityTester lambda expression */
-list_t join(list_t list1, list_t list2, bool_t(*expression)(T, T));
+list_t join(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  JoinWhere
@@ -762,7 +1994,7 @@ list_t join(list_t list1, list_t list2, bool_t(*expression)(T, T));
 *    list2 ---> The second list_t, it can have an arbitrary length
 *    condition ---> Selector lambda expression
 *    expression ---> EqualityTester lambda expression */
-list_t join_where(list_t list1, list_t list2, bool_t(*condition)(T), bool_t(*expression)(T, T));
+list_t join_where(list_t list1, list_t list2, bool_t(*condition)(item_arg_t), bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Intersect
@@ -770,11 +2002,13 @@ list_t join_where(list_t list1, list_t list2, bool_t(*condition)(T), bool_t(*exp
 *  Description:
 *    Performs the intersection between two list_ts. Returns NULL
 *    if either one of the two list_ts is NULL.
+*    With a NULL expression the items are compared with == (or
+*    LIST_EQUALS), using the hash index and the bloom filter of list2.
 *  Parameters:
 *    list1 ---> The first input list_t
 *    list2 ---> The second list_t, it can have an arbitrary length
 *    expression ---> EqualityTester lambda expression */
-list_t intersect(list_t list1, list_t list2, bool_t(*expression)(T, T));
+list_t intersect(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Except
@@ -784,11 +2018,13 @@ list_t intersect(list_t list1, list_t list2, bool_t(*expression)(T, T));
 *    i.e: it returns a new list_t that contains all the elements that
 *    were present inside the first list_t and not in the second one.
 *    Returns NULL if either one of the two list_ts is NULL.
+*    With a NULL expression the items are compared with == (or
+*    LIST_EQUALS), using the hash index and the bloom filter of list2.
 *  Parameters:
 *    list1 ---> The first input list_t
 *    list2 ---> The second list_t, it can have an arbitrary length
 *    expression ---> EqualityTester lambda expression */
-list_t except(list_t list1, list_t list2, bool_t(*expression)(T, T));
+list_t except(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Reverse
@@ -825,7 +2061,7 @@ list_t reverse_range(list_t list, int start, int end);
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> ToNumber lambda expression */
-int sum(list_t list, int(*expression)(T));
+int sum(list_t list, int(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Average
@@ -837,7 +2073,7 @@ int sum(list_t list, int(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> ToNumber lambda expression */
-int average(list_t list, int(*expression)(T));
+int average(list_t list, int(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  GetNumericMin
@@ -849,7 +2085,7 @@ int average(list_t list, int(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> ToNumber lambda expression */
-int get_numeric_min(list_t list, int(*expression)(T));
+int get_numeric_min(list_t list, int(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  GetMin
@@ -862,7 +2098,7 @@ int get_numeric_min(list_t list, int(*expression)(T));
 *    list ---> The input list_t
 *    result ---> Pointer to the result T value
 *    expression ---> Comparator lambda expression */
-bool_t get_min(list_t list, T* result, comparation(*expression)(T, T));
+bool_t get_min(list_t list, T* result, comparation(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  GetNumericMax
@@ -874,7 +2110,7 @@ bool_t get_min(list_t list, T* result, comparation(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> ToNumber lambda expression */
-int get_numeric_max(list_t list, int(*expression)(T));
+int get_numeric_max(list_t list, int(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  GetMax
@@ -887,7 +2123,7 @@ int get_numeric_max(list_t list, int(*expression)(T));
 *    list ---> The input list_t
 *    result ---> Pointer to the result T value
 *    expression ---> Comparator lambda expression */
-bool_t get_max(list_t list, T* result, comparation(*expression)(T, T));
+bool_t get_max(list_t list, T* result, comparation(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  OrderBy
@@ -901,7 +2137,7 @@ bool_t get_max(list_t list, T* result, comparation(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Comparator lambda expression */
-list_t order_by(list_t list, comparation(*expression)(T, T));
+list_t order_by(list_t list, comparation(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  OrderByDescending
@@ -912,7 +2148,7 @@ list_t order_by(list_t list, comparation(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Comparator lambda expression */
-list_t order_by_descending(list_t list, comparation(*expression)(T, T));
+list_t order_by_descending(list_t list, comparation(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  InPlaceOrderBy
@@ -925,7 +2161,7 @@ list_t order_by_descending(list_t list, comparation(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Comparator lambda expression */
-list_t in_place_order_by(list_t list, comparation(*expression)(T, T));
+list_t in_place_order_by(list_t list, comparation(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  InPlaceOrderByDescending
@@ -938,7 +2174,7 @@ list_t in_place_order_by(list_t list, comparation(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Comparator lambda expression */
-list_t in_place_order_by_descending(list_t list, comparation(*expression)(T, T));
+list_t in_place_order_by_descending(list_t list, comparation(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Distinct
@@ -950,7 +2186,7 @@ list_t in_place_order_by_descending(list_t list, comparation(*expression)(T, T))
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> EqualityTester lambda expression */
-list_t distinct(list_t list, bool_t(*expression)(T, T));
+list_t distinct(list_t list, bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  CountDistinct
@@ -961,7 +2197,7 @@ list_t distinct(list_t list, bool_t(*expression)(T, T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> EqualityTester lambda expression */
-int count_distinct(list_t list, bool_t(*expression)(T, T));
+int count_distinct(list_t list, bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Single
@@ -975,7 +2211,7 @@ int count_distinct(list_t list, bool_t(*expression)(T, T));
 *    list ---> The input list_t
 *    result ---> Pointer to the result T value
 *    expression ---> Selector lambda expression */
-bool_t single(list_t list, T* result, bool_t(*expression)(T));
+bool_t single(list_t list, T* result, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  RemoveWhere
@@ -987,7 +2223,7 @@ bool_t single(list_t list, T* result, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Selector lambda expression */
-list_t remove_where(list_t list, bool_t(*expression)(T));
+list_t remove_where(list_t list, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  ReplaceWhere
@@ -1000,7 +2236,7 @@ list_t remove_where(list_t list, bool_t(*expression)(T));
 *    list ---> The input list_t
 *    replacement ---> The value to use when replacing an item
 *    expression ---> Selector lambda expression */
-list_t replace_where(list_t list, const T replacement, bool_t(*expression)(T));
+list_t replace_where(list_t list, const T replacement, bool_t(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Derive
@@ -1011,7 +2247,7 @@ list_t replace_where(list_t list, const T replacement, bool_t(*expression)(T));
 *  Parameters:
 *    list ---> The input list_t
 *    expression ---> Deriver lambda expression */
-list_t derive(list_t list, T(*expression)(T));
+list_t derive(list_t list, T(*expression)(item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  SequenceEquals
@@ -1024,7 +2260,7 @@ list_t derive(list_t list, T(*expression)(T));
 *    list1 ---> The input list_t
 *    list2 ---> Should have the same length as the first one
 *    expression ---> EqualityTester lambda expression */
-bool_t sequence_equals(list_t list1, list_t list2, bool_t(*expression)(T, T));
+bool_t sequence_equals(list_t list1, list_t list2, bool_t(*expression)(item_arg_t, item_arg_t));
 
 /* ---------------------------------------------------------------------
 *  Trim
@@ -1032,12 +2268,546 @@ bool_t sequence_equals(list_t list1, list_t list2, bool_t(*expression)(T, T));
 *  Description:
 *    Returns a new list with all the elements from the first one, and
 *    the maximum length adjusted to the given number.
+*    Use slice to read the same items without copying them.
 *    Returns NULL if the list_t is either NULL or empty.
 *  Parameters:
 *    list ---> The source list_t
 *    length ---> The maximum length for the new list_t */
 list_t trim(list_t list, int length);
 
+/* =====================================================================
+*  Grouping
+*  =====================================================================
+*  Description:
+*    Functions that split the items of a list_t into groups with the
+*    same key in a single pass, and return a lookup_t from each key to
+*    its group, instead of calling where once for each key.
+*    The key of an item is returned by a Deriver lambda expression, and
+*    the keys are compared with a Hasher and an EqualityTester: when
+*    they are NULL, the keys are hashed like the items of a hash index
+*    (see enable_hash_index) and compared with == (or LIST_EQUALS).
+*    The keys of a lookup_t are in the order of their first item, and
+*    the items of each group keep their order inside the list_t.
+*  NOTE:
+*    count_by, sum_by, min_by and max_by only store a number for each
+*    group, without copying its items. */
+
+/* ---------------------------------------------------------------------
+*  GroupBy
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a lookup_t with a new list_t for each key, that contains
+*    the items of the list_t with that key (see lookup_get).
+*    Returns NULL if the list_t or the key expression were NULL.
+*  Parameters:
+*    list ---> The input list_t
+*    key ---> Deriver lambda expression that returns the key of an item
+*    hash ---> Hasher lambda expression for the keys, or NULL
+*    equals ---> EqualityTester lambda expression for the keys, or NULL */
+lookup_t group_by(list_t list, T(*key)(item_arg_t), size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  GroupByParallel
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as group_by, but it splits the list_t into consecutive ranges
+*    (of at least 4096 items each) that are grouped by different threads,
+*    each one with its own partial lookup_t, and then merges the partial
+*    lookups in order, so the result is the same as the one of group_by.
+*    The expressions are called by different threads at the same time,
+*    so they must not change any shared state.
+*  Parameters:
+*    list ---> The input list_t
+*    key ---> Deriver lambda expression that returns the key of an item
+*    hash ---> Hasher lambda expression for the keys, or NULL
+*    equals ---> EqualityTester lambda expression for the keys, or NULL
+*    threads ---> The maximum number of threads to use (at most 64) */
+lookup_t group_by_parallel(list_t list, T(*key)(item_arg_t), size_t(*hash)(item_arg_t),
+	bool_t(*equals)(item_arg_t, item_arg_t), int threads);
+
+/* ---------------------------------------------------------------------
+*  CountBy
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a lookup_t with the number of items of the list_t that
+*    have each key (see lookup_value).
+*    Returns NULL if the list_t or the key expression were NULL.
+*  Parameters:
+*    list ---> The input list_t
+*    key ---> Deriver lambda expression that returns the key of an item
+*    hash ---> Hasher lambda expression for the keys, or NULL
+*    equals ---> EqualityTester lambda expression for the keys, or NULL */
+lookup_t count_by(list_t list, T(*key)(item_arg_t), size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  SumBy
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a lookup_t with the sum of the numeric values of the items
+*    of the list_t that have each key (see lookup_value).
+*    Returns NULL if the list_t or one of the expressions were NULL.
+*  Parameters:
+*    list ---> The input list_t
+*    key ---> Deriver lambda expression that returns the key of an item
+*    expression ---> ToNumber lambda expression
+*    hash ---> Hasher lambda expression for the keys, or NULL
+*    equals ---> EqualityTester lambda expression for the keys, or NULL */
+lookup_t sum_by(list_t list, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  MinBy
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as sum_by, but it keeps the minimum numeric value of the
+*    items with each key.
+*  Parameters:
+*    list ---> The input list_t
+*    key ---> Deriver lambda expression that returns the key of an item
+*    expression ---> ToNumber lambda expression
+*    hash ---> Hasher lambda expression for the keys, or NULL
+*    equals ---> EqualityTester lambda expression for the keys, or NULL */
+lookup_t min_by(list_t list, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  MaxBy
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as sum_by, but it keeps the maximum numeric value of the
+*    items with each key.
+*  Parameters:
+*    list ---> The input list_t
+*    key ---> Deriver lambda expression that returns the key of an item
+*    expression ---> ToNumber lambda expression
+*    hash ---> Hasher lambda expression for the keys, or NULL
+*    equals ---> EqualityTester lambda expression for the keys, or NULL */
+lookup_t max_by(list_t list, T(*key)(item_arg_t), int(*expression)(item_arg_t),
+	size_t(*hash)(item_arg_t), bool_t(*equals)(item_arg_t, item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  LookupSize
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns the number of keys inside the lookup_t, or -1 if it is NULL.
+*  Parameters:
+*    lookup ---> The input lookup_t */
+int lookup_size(lookup_t lookup);
+
+/* ---------------------------------------------------------------------
+*  LookupGet
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns the list_t with the items of the given key, or NULL if the
+*    lookup_t was NULL, it doesn't have that key or it wasn't returned
+*    by group_by (or group_by_parallel). The list_t belongs to the
+*    lookup_t: it can be edited, but it is deallocated by destroy_lookup.
+*  Parameters:
+*    lookup ---> The input lookup_t
+*    key ---> The key to look for */
+list_t lookup_get(lookup_t lookup, const T key);
+
+/* ---------------------------------------------------------------------
+*  LookupValue
+*  ---------------------------------------------------------------------
+*  Description:
+*    Assigns to result the value of the given key: the number of its
+*    items for group_by and count_by, or the sum, min or max of their
+*    numeric values. Returns FALSE if the lookup_t was NULL or it
+*    doesn't have that key.
+*  Parameters:
+*    lookup ---> The input lookup_t
+*    key ---> The key to look for
+*    result ---> A pointer to the variable to fill */
+bool_t lookup_value(lookup_t lookup, const T key, int* result);
+
+/* ---------------------------------------------------------------------
+*  LookupKeys
+*  ---------------------------------------------------------------------
+*  Description:
+*    Returns a new list_t with the keys of the lookup_t, in the order of
+*    their first item. Returns NULL if the lookup_t was NULL.
+*  Parameters:
+*    lookup ---> The input lookup_t */
+list_t lookup_keys(lookup_t lookup);
+
+/* ---------------------------------------------------------------------
+*  DestroyLookup
+*  ---------------------------------------------------------------------
+*  Description:
+*    Deallocates a lookup_t and the lists of its groups. Returns TRUE
+*    if the operation was successful, FALSE if it was already NULL.
+*  Parameters:
+*    lookup ---> A pointer to the lookup_t to deallocate */
+bool_t destroy_lookup(lookup_t* lookup);
+
+/* =====================================================================
+*  Specialized LINQ
+*  =====================================================================
+*  Description:
+*    Macros that define a specialized version of a LINQ function, with
+*    its expression written inline instead of passed as a lambda: the
+*    compiler sees the expression inside the loop, so it can inline it
+*    and vectorize the loop, without any call through a function pointer
+*    (and without the executable stack that GCC needs for a lambda
+*    expression that uses the local variables of its function).
+*    Each macro defines a static function with the given name, so it has
+*    to be used outside of any function.
+*  NOTE:
+*    DEFINE_WHERE, DEFINE_COUNT and DEFINE_SORT use the unnamed list_t,
+*    while their DEFINE_NAMED_ versions take the LIST_NAME of a list type
+*    declared before (see the NOTE at the top of this file). */
+
+// Build the names used by the specialized functions: the unnamed list_t
+// keeps the plain names, while a named one adds its LIST_NAME prefix
+#define LIST_UNNAMED_SYMBOL(list_name, symbol) symbol
+#define LIST_NAMED_SYMBOL(list_name, symbol) list_name##_##symbol
+
+// Number of items copied at a time by LIST_SCAN_ITEMS from a list_t with nodes
+#define LIST_SCAN_COUNT(type) (sizeof(type) < 4096 ? 4096 / sizeof(type) : 1)
+
+// Internal macro used by the specialized functions: runs the code for
+// each item of a list_t, reading its array directly when it has one or
+// copying its nodes inside a local buffer, a chunk at a time. namer and
+// list_name select the list type, with LIST_UNNAMED_SYMBOL or LIST_NAMED_SYMBOL
+#define LIST_SCAN_ITEMS(namer, list_name, list, var_name, ...)                 \
+{                                                                              \
+	typedef namer(list_name, T) scanItem;                                      \
+	scanItem scanBuffer[LIST_SCAN_COUNT(scanItem)];                            \
+	int scanLength, scanIndex;                                                 \
+	const scanItem* scanItems = namer(list_name, to_array_borrow)(list, &scanLength); \
+	namer(list_name, list_iterator_t) scanIterator = NULL;                     \
+	if (scanItems == NULL)                                                     \
+	{                                                                          \
+		scanItems = scanBuffer;                                                \
+		scanIterator = namer(list_name, get_iterator)(list);                   \
+		scanLength = namer(list_name, next_chunk)(scanIterator, scanBuffer, LIST_SCAN_COUNT(scanItem)); \
+	}                                                                          \
+	while (scanLength > 0)                                                     \
+	{                                                                          \
+		for (scanIndex = 0; scanIndex < scanLength; scanIndex++)               \
+		{                                                                      \
+			scanItem var_name = scanItems[scanIndex];                          \
+			__VA_ARGS__                                                        \
+		}                                                                      \
+		scanLength = scanIterator == NULL ? 0                                  \
+			: namer(list_name, next_chunk)(scanIterator, scanBuffer, LIST_SCAN_COUNT(scanItem)); \
+	}                                                                          \
+	namer(list_name, destroy_iterator)(&scanIterator);                         \
+}
+
+// Internal macro used by DEFINE_WHERE and DEFINE_NAMED_WHERE
+#define LIST_DEFINE_WHERE(namer, list_name, name, var_name, condition)         \
+static namer(list_name, list_t) name(namer(list_name, list_t) list)            \
+{                                                                              \
+	typedef namer(list_name, T) whereItem;                                     \
+	int whereLength, whereCount = 0, whereIndex;                               \
+	whereItem* whereItems = namer(list_name, to_array)(list, &whereLength);    \
+	if (whereItems == NULL) return NULL;                                       \
+	for (whereIndex = 0; whereIndex < whereLength; whereIndex++)               \
+	{                                                                          \
+		whereItem var_name = whereItems[whereIndex];                           \
+		whereItems[whereCount] = var_name;                                     \
+		whereCount += (condition) != 0;                                        \
+	}                                                                          \
+	if (whereCount == 0)                                                       \
+	{                                                                          \
+		free(whereItems);                                                      \
+		return namer(list_name, create)();                                     \
+	}                                                                          \
+	whereItem* whereTrimmed = (whereItem*)realloc(whereItems, sizeof(whereItem) * whereCount); \
+	return namer(list_name, create_adopting)(whereTrimmed != NULL ? whereTrimmed : whereItems, whereCount, free); \
+}
+
+/* ---------------------------------------------------------------------
+*  DefineWhere
+*  ---------------------------------------------------------------------
+*  Description:
+*    Defines a function that works like Where, with the given condition:
+*    list_t name(list_t list). The items are copied inside a single
+*    array, that is compacted without any branch and then adopted by
+*    the new list_t.
+*  Example:
+*    DEFINE_WHERE(where_even, number, number % 2 == 0)
+*    ...
+*    list_t even = where_even(list);
+*  Parameters:
+*    name ---> The name of the new function
+*    var_name ---> The name of the item inside the condition
+*    condition ---> The condition an item has to satisfy */
+#define DEFINE_WHERE(name, var_name, condition)                                \
+LIST_DEFINE_WHERE(LIST_UNNAMED_SYMBOL, , name, var_name, condition)
+
+/* ---------------------------------------------------------------------
+*  DefineNamedWhere
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as DEFINE_WHERE, but for a list type declared with LIST_NAME:
+*    list_name_list_t name(list_name_list_t list).
+*  Example:
+*    DEFINE_NAMED_WHERE(point_list, where_positive, p, p.x > 0 && p.y > 0)
+*  Parameters:
+*    list_name ---> The LIST_NAME of the list type
+*    name ---> The name of the new function
+*    var_name ---> The name of the item inside the condition
+*    condition ---> The condition an item has to satisfy */
+#define DEFINE_NAMED_WHERE(list_name, name, var_name, condition)               \
+LIST_DEFINE_WHERE(LIST_NAMED_SYMBOL, list_name, name, var_name, condition)
+
+// Internal macro used by DEFINE_COUNT and DEFINE_NAMED_COUNT
+#define LIST_DEFINE_COUNT(namer, list_name, name, var_name, condition)         \
+static int name(namer(list_name, list_t) list)                                 \
+{                                                                              \
+	if (namer(list_name, is_empty)(list)) return -1;                           \
+	int countTotal = 0;                                                        \
+	LIST_SCAN_ITEMS(namer, list_name, list, var_name, countTotal += (condition) != 0;) \
+	return countTotal;                                                         \
+}
+
+/* ---------------------------------------------------------------------
+*  DefineCount
+*  ---------------------------------------------------------------------
+*  Description:
+*    Defines a function that works like Count, with the given condition:
+*    int name(list_t list). It returns -1 if the list_t is NULL or empty.
+*  Example:
+*    DEFINE_COUNT(count_positive, number, number > 0)
+*  Parameters:
+*    name ---> The name of the new function
+*    var_name ---> The name of the item inside the condition
+*    condition ---> The condition an item has to satisfy */
+#define DEFINE_COUNT(name, var_name, condition)                                \
+LIST_DEFINE_COUNT(LIST_UNNAMED_SYMBOL, , name, var_name, condition)
+
+/* ---------------------------------------------------------------------
+*  DefineNamedCount
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as DEFINE_COUNT, but for a list type declared with LIST_NAME:
+*    int name(list_name_list_t list).
+*  Example:
+*    DEFINE_NAMED_COUNT(point_list, count_on_axes, p, p.x == 0 || p.y == 0)
+*  Parameters:
+*    list_name ---> The LIST_NAME of the list type
+*    name ---> The name of the new function
+*    var_name ---> The name of the item inside the condition
+*    condition ---> The condition an item has to satisfy */
+#define DEFINE_NAMED_COUNT(list_name, name, var_name, condition)               \
+LIST_DEFINE_COUNT(LIST_NAMED_SYMBOL, list_name, name, var_name, condition)
+
+// Internal macro used by the specialized sort to swap two items
+#define LIST_SWAP_ITEMS(items, index1, index2)                                 \
+{                                                                              \
+	__typeof__(items[0]) swapTemp = items[index1];                             \
+	items[index1] = items[index2];                                             \
+	items[index2] = swapTemp;                                                  \
+}
+
+// Internal macro used by DEFINE_SORT and DEFINE_NAMED_SORT
+#define LIST_DEFINE_SORT(namer, list_name, name, var1_name, var2_name, less)   \
+typedef namer(list_name, T) name##_item;                                       \
+                                                                               \
+static inline bool_t name##_less(name##_item var1_name, name##_item var2_name) \
+{                                                                              \
+	return (less) != 0;                                                        \
+}                                                                              \
+                                                                               \
+static void name##_sift(name##_item* items, int root, int length)              \
+{                                                                              \
+	int child;                                                                 \
+	while ((child = root * 2 + 1) < length)                                    \
+	{                                                                          \
+		if (child + 1 < length && name##_less(items[child], items[child + 1])) child++; \
+		if (!name##_less(items[root], items[child])) return;                   \
+		LIST_SWAP_ITEMS(items, root, child);                                   \
+		root = child;                                                          \
+	}                                                                          \
+}                                                                              \
+                                                                               \
+static void name##_sort(name##_item* items, int length, int depth)             \
+{                                                                              \
+	while (length > 16)                                                        \
+	{                                                                          \
+		int i, j;                                                              \
+		if (depth-- == 0)                                                      \
+		{                                                                      \
+			for (i = length / 2 - 1; i >= 0; i--) name##_sift(items, i, length); \
+			for (i = length - 1; i > 0; i--)                                   \
+			{                                                                  \
+				LIST_SWAP_ITEMS(items, 0, i);                                  \
+				name##_sift(items, 0, i);                                      \
+			}                                                                  \
+			return;                                                            \
+		}                                                                      \
+                                                                               \
+		/* Hoare partition around the median of three items */                 \
+		int middle = (length - 1) / 2;                                         \
+		if (name##_less(items[middle], items[0])) LIST_SWAP_ITEMS(items, 0, middle); \
+		if (name##_less(items[length - 1], items[0])) LIST_SWAP_ITEMS(items, 0, length - 1); \
+		if (name##_less(items[length - 1], items[middle])) LIST_SWAP_ITEMS(items, middle, length - 1); \
+		name##_item pivot = items[middle];                                     \
+		i = -1;                                                                \
+		j = length;                                                            \
+		while (TRUE)                                                           \
+		{                                                                      \
+			do i++; while (name##_less(items[i], pivot));                      \
+			do j--; while (name##_less(pivot, items[j]));                      \
+			if (i >= j) break;                                                 \
+			LIST_SWAP_ITEMS(items, i, j);                                      \
+		}                                                                      \
+                                                                               \
+		/* Sort the smaller part first, then continue with the larger one */   \
+		if (j + 1 < length - j - 1)                                            \
+		{                                                                      \
+			name##_sort(items, j + 1, depth);                                  \
+			items += j + 1;                                                    \
+			length -= j + 1;                                                   \
+		}                                                                      \
+		else                                                                   \
+		{                                                                      \
+			name##_sort(items + j + 1, length - j - 1, depth);                 \
+			length = j + 1;                                                    \
+		}                                                                      \
+	}                                                                          \
+	int i, j;                                                                  \
+	for (i = 1; i < length; i++)                                               \
+	{                                                                          \
+		name##_item item = items[i];                                           \
+		for (j = i; j > 0 && name##_less(item, items[j - 1]); j--) items[j] = items[j - 1]; \
+		items[j] = item;                                                       \
+	}                                                                          \
+}                                                                              \
+                                                                               \
+static namer(list_name, list_t) name(namer(list_name, list_t) list)            \
+{                                                                              \
+	if (namer(list_name, is_empty)(list)) return NULL;                         \
+	int length, depth = 0;                                                     \
+	name##_item* items = namer(list_name, to_array)(list, &length);            \
+	if (items == NULL) return NULL;                                            \
+	while ((1 << depth) < length) depth++;                                     \
+	name##_sort(items, length, depth * 2);                                     \
+	return namer(list_name, create_adopting)(items, length, free);             \
+}
+
+/* ---------------------------------------------------------------------
+*  DefineSort
+*  ---------------------------------------------------------------------
+*  Description:
+*    Defines a function that works like OrderBy, with the given condition
+*    to check if an item goes before another one: list_t name(list_t list).
+*    The items are copied inside a single array, sorted with an introsort
+*    that uses the condition inline and then adopted by the new list_t.
+*    It returns NULL if the list_t is NULL or empty.
+*  Example:
+*    DEFINE_SORT(sort_descending, number1, number2, number1 > number2)
+*  Parameters:
+*    name ---> The name of the new function
+*    var1_name ---> The name of the first item inside the condition
+*    var2_name ---> The name of the second item inside the condition
+*    less ---> The condition that is TRUE when the first item goes
+*    before the second one */
+#define DEFINE_SORT(name, var1_name, var2_name, less)                          \
+LIST_DEFINE_SORT(LIST_UNNAMED_SYMBOL, , name, var1_name, var2_name, less)
+
+/* ---------------------------------------------------------------------
+*  DefineNamedSort
+*  ---------------------------------------------------------------------
+*  Description:
+*    Same as DEFINE_SORT, but for a list type declared with LIST_NAME:
+*    list_name_list_t name(list_name_list_t list).
+*  Example:
+*    DEFINE_NAMED_SORT(point_list, sort_by_distance, p1, p2,
+*        p1.x * p1.x + p1.y * p1.y < p2.x * p2.x + p2.y * p2.y)
+*  Parameters:
+*    list_name ---> The LIST_NAME of the list type
+*    name ---> The name of the new function
+*    var1_name ---> The name of the first item inside the condition
+*    var2_name ---> The name of the second item inside the condition
+*    less ---> The condition that is TRUE when the first item goes
+*    before the second one */
+#define DEFINE_NAMED_SORT(list_name, name, var1_name, var2_name, less)         \
+LIST_DEFINE_SORT(LIST_NAMED_SYMBOL, list_name, name, var1_name, var2_name, less)
+
+/* =====================================================================
+*  In-place LINQ
+*  =====================================================================
+*  Description:
+*    In-place counterparts of some of the LINQ functions above: instead
+*    of building a new list_t, they edit the nodes of the input one.
+*    This way the peak memory usage stays at a single list_t.
+*  NOTE:
+*    All the functions inside this section work with SIDE EFFECT. */
+
+/* ---------------------------------------------------------------------
+*  WhereInPlace
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes from the list_t all the elements that don't satisfy the
+*    given expression. Returns the number of removed items, or -1 if
+*    the list_t was NULL or empty.
+*  Parameters:
+*    list ---> The list_t to edit
+*    expression ---> Selector lambda expression */
+int where_in_place(list_t list, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  RemoveWhereInPlace
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes from the list_t all the elements that satisfy the given
+*    expression. Returns the number of removed items, or -1 if the
+*    list_t was NULL or empty.
+*  Parameters:
+*    list ---> The list_t to edit
+*    expression ---> Selector lambda expression */
+int remove_where_in_place(list_t list, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  ReplaceWhereInPlace
+*  ---------------------------------------------------------------------
+*  Description:
+*    Replaces all the items that satisfy the expression with the given
+*    constant value. Returns the number of replaced items, or -1 if the
+*    list_t was NULL or empty.
+*  Parameters:
+*    list ---> The list_t to edit
+*    replacement ---> The value to use when replacing an item
+*    expression ---> Selector lambda expression */
+int replace_where_in_place(list_t list, const T replacement, bool_t(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  DeriveInPlace
+*  ---------------------------------------------------------------------
+*  Description:
+*    Applies the given expression to each element and stores the result
+*    inside the same node. Returns FALSE if the list_t is NULL or empty.
+*  Parameters:
+*    list ---> The list_t to edit
+*    expression ---> Deriver lambda expression */
+bool_t derive_in_place(list_t list, T(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  ReverseInPlace
+*  ---------------------------------------------------------------------
+*  Description:
+*    Reverses the order of the elements by relinking the existing nodes.
+*    Returns FALSE if the list_t is NULL or empty.
+*  Parameters:
+*    list ---> The list_t to edit */
+bool_t reverse_in_place(list_t list);
+
+/* ---------------------------------------------------------------------
+*  DistinctInPlace
+*  ---------------------------------------------------------------------
+*  Description:
+*    Removes all the duplicate items from the list_t, keeping the first
+*    occurrence of each one. Returns the number of removed items, or -1
+*    if the list_t was NULL or empty.
+*  Parameters:
+*    list ---> The list_t to edit
+*    expression ---> EqualityTester lambda expression */
+int distinct_in_place(list_t list, bool_t(*expression)(item_arg_t, item_arg_t));
+
 /* =====================================================================
 *  Iterator
 *  =====================================================================
@@ -1188,7 +2958,27 @@ int elements_left(list_iterator_t iterator);
 *  Parameters:
 *    iterator ---> The input iterator
 *    expression ---> Block lambda expression */
-int for_each_remaining(list_iterator_t iterator, void(*expression)(T));
+int for_each_remaining(list_iterator_t iterator, void(*expression)(item_arg_t));
+
+/* ---------------------------------------------------------------------
+*  NextChunk
+*  ---------------------------------------------------------------------
+*  Description:
+*    Works like the Next function, but it copies up to capacity items
+*    inside the given buffer and moves the Iterator to the last one.
+*    It can be called repeatedly to export the whole list_t in batches
+*    using a single buffer, and the Restart function makes the Iterator
+*    ready to export it again. Returns the number of copied items, 0 if
+*    there are no items left, or -1 if the Iterator or the buffer are
+*    NULL or if the Iterator is out of sync.
+*  Example:
+*    while ((count = next_chunk(iterator, buffer, 4096)) > 0)
+*        fwrite(buffer, sizeof(T), count, file);
+*  Parameters:
+*    iterator ---> The input iterator
+*    buffer ---> The target buffer
+*    capacity ---> The maximum number of items to copy */
+int next_chunk(list_iterator_t iterator, T* buffer, int capacity);
 
 /* ---------------------------------------------------------------------
 *  Restart
@@ -1200,6 +2990,19 @@ int for_each_remaining(list_iterator_t iterator, void(*expression)(T));
 *    iterator ---> The input iterator */
 bool_t restart(list_iterator_t iterator);
 
+// Remove the names of a named list type, so that another one can be included
+#if defined(LIST_NAME) && !defined(LIST_T_C)
+#define LIST_UNDEF_NAMES
+#include "list_names.h"
+#undef LIST_UNDEF_NAMES
+#undef LIST_NAME
+#undef LIST_TYPE
+#undef LIST_EQUALS
+#undef LIST_NOT_NUMERIC
+#undef LIST_BY_POINTER
+#undef LIST_HASH
+#endif
+
 #endif
 
 /* Copyright (C) 2015 Sergio Pedri and Andrea Salvati
@@ -15,14 +15,35 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "Library\list_t.h"
+
+// A second list type, with points instead of int values: its functions
+// are compiled at the end of this file, and its callbacks get a pointer
+// to each point instead of a copy of it
+struct point { int x; int y; };
+#define LIST_NAME point_list
+#define LIST_TYPE struct point
+#define LIST_NOT_NUMERIC
+#define LIST_BY_POINTER
 #include "Library\list_t.h"
 
 void getch();
 void generic_functions_test();
 void stack_test();
 void LINQ_test();
+void in_place_LINQ_test();
 void iterator_test();
+void named_list_test();
 void sorting_benchmarks();
+void stack_benchmarks();
+void queue_benchmarks();
+void append_benchmarks();
+void rcu_benchmarks();
+void index_benchmarks();
+void bloom_benchmarks();
+void grouping_benchmarks();
 
 #define BOOL_STRING(value) value ? "True" : "False"
 #define NULL_STRING(value) BOOL_STRING(value == NULL)
@@ -36,13 +57,30 @@ PRINT_BOOL(size(list) == expected)
 #define PRINT_EXPECTED_SIZE_STACK PRINT_EXPECTED_SIZE_GENERIC(stack)
 #define PRINT_LIST formatted_print("%d", test)
 
+// Specialized LINQ functions, with the expressions inlined in their loops
+DEFINE_COUNT(count_even_positive, item, !(item % 2) && item > 0)
+DEFINE_WHERE(where_multiple_of_3, item, !(item % 3) && item != 0)
+DEFINE_SORT(sort_ascending, item1, item2, item1 < item2)
+DEFINE_NAMED_COUNT(point_list, count_above_axis, p, p.y > 0)
+DEFINE_NAMED_WHERE(point_list, where_even_x, p, p.x % 2 == 0)
+DEFINE_NAMED_SORT(point_list, sort_by_x_descending, p1, p2, p1.x > p2.x)
+
 int main(void)
 {
 	generic_functions_test();
 	stack_test();
 	LINQ_test();
+	in_place_LINQ_test();
 	iterator_test();
+	named_list_test();
 	sorting_benchmarks();
+	stack_benchmarks();
+	queue_benchmarks();
+	append_benchmarks();
+	rcu_benchmarks();
+	index_benchmarks();
+	bloom_benchmarks();
+	grouping_benchmarks();
 	printf("\n\n======== TESTS COMPLETED ========\n");
 	return 0;
 }
@@ -71,6 +109,53 @@ void generic_functions_test()
 	PRINT_LIST;
 	PRINT_EXPECTED_SIZE;
 
+	// Snapshot
+	list_t view = snapshot(copied);
+	remove_at(copied, 0);
+	printf("\n\n>> Snapshot of the copy, taken before removing its first item:\n");
+	formatted_print("%d", view);
+	destroy(&view);
+
+	// Slice
+	view = slice(copied, 2, 6);
+	printf("\n\n>> Slice of the copy from index 2 to 6, sum %d:\n", sum(view, lambda(int, (T x) { return x; })));
+	formatted_print("%d", view);
+	add(10, copied);
+	printf("\n\n>> The slice is empty after an edit of the copy: ");
+	PRINT_BOOL(is_empty(view));
+	destroy(&view);
+
+	// A stale slice never reads the old nodes of its source
+	view = slice(copied, 2, 6);
+	remove_at(copied, 3);
+	remove_at(copied, 3);
+	add(11, copied);
+	add(12, copied);
+	T item;
+	printf("\n>> After two removals and two additions the slice has size %d, get fails: ", size(view));
+	PRINT_BOOL(!get(view, 0, &item));
+	list_t difference = except(copied, view, NULL);
+	printf("\n>> except keeps all the items of the copy: ");
+	PRINT_BOOL(size(difference) == size(copied));
+	destroy(&difference);
+	destroy(&view);
+	list_t cleared = copy(copied);
+	view = slice(cleared, 1, 5);
+	clear(cleared);
+	printf("\n>> The slice of a cleared list_t is empty: \"");
+	formatted_print("%d", view);
+	printf("\", size %d", size(view));
+	destroy(&view);
+	destroy(&cleared);
+
+	// Concurrent list_t
+	list_t shared = create_concurrent();
+	add_all(shared, copied);
+	printf("\n\n>> Concurrent list_t with the items of the copy, sum %d", sum(shared, lambda(int, (T x) { return x; })));
+	int edits = count(shared, lambda(bool_t, (T x) { return add(x, shared); }));
+	printf("\n>> Edits from inside a read of the concurrent list_t: %d, size %d", edits, size(shared));
+	destroy(&shared);
+
 	// Destroy list_t
 	destroy(&copied);
 	printf("\n\n>> Copy destroyed, pointer = NULL ---> ");
@@ -116,6 +201,117 @@ void generic_functions_test()
 	PRINT_LIST;
 	PRINT_EXPECTED_SIZE;
 
+	// Copy to
+	T buffer[4];
+	int total = copy_to(test, buffer, 4, 2);
+	printf("\n\n>> Copied %d items from index 2 into a buffer:\n", total);
+	for (i = 0; i < total; i++) printf("%d ", buffer[i]);
+
+	// Adopt an array
+	T* adopted = to_array(test, &length);
+	list_t borrowed = create_adopting(adopted, length, free);
+	printf("\n\n>> list_t adopting a copy of the array:\n");
+	formatted_print("%d", borrowed);
+	const T* storage = to_array_borrow(borrowed, &length);
+	printf("\n\n>> Borrowed storage, same as the array: ");
+	PRINT_BOOL(storage == adopted);
+	destroy(&borrowed);
+
+	// Save and load
+	FILE* file = tmpfile();
+	if (file != NULL)
+	{
+		save_list(test, file);
+		rewind(file);
+		list_t loaded = load_list(file);
+		fclose(file);
+		printf("\n\n>> list_t saved to a binary file and loaded again:\n");
+		formatted_print("%d", loaded);
+		destroy(&loaded);
+	}
+
+	// Map list
+	file = fopen("list_t_test.bin", "wb");
+	if (file != NULL)
+	{
+		save_list(test, file);
+		fclose(file);
+		list_t mapped = map_list("list_t_test.bin");
+		printf("\n\n>> list_t mapped from a binary file, count: %d, add allowed: ", size(mapped));
+		PRINT_BOOL(add(42, mapped));
+		destroy(&mapped);
+		remove("list_t_test.bin");
+	}
+
+	// Streams
+	file = tmpfile();
+	if (file != NULL)
+	{
+		T* items = to_array(test, &length);
+		fwrite(items, sizeof(T), length, file);
+		free(items);
+		rewind(file);
+		list_stream_t stream = open_stream(file);
+		T first;
+		stream_first_or_default(stream, &first, lambda(bool_t, (T x) { return x > 5; }));
+		printf("\n\n>> Raw items streamed from a file, first > 5: %d, items > 5 after it: %d", first,
+			stream_count(stream, lambda(bool_t, (T x) { return x > 5; })));
+		close_stream(&stream);
+		fclose(file);
+	}
+
+	// Print to a buffer
+	char text[64];
+	int chars = formatted_print_buffer(text, sizeof(text), "<%d>", test);
+	printf("\n\n>> list_t printed to a buffer (%d chars): %s", chars, text);
+
+	// Parse list
+	int error;
+	chars = formatted_print_buffer(text, sizeof(text), "%d", test);
+	list_t parsed = parse_list(text, chars < (int)sizeof(text) ? chars : (int)sizeof(text) - 1, ',', &error);
+	printf("\n\n>> list_t parsed from the same text:\n");
+	formatted_print("%d", parsed);
+	destroy(&parsed);
+	parsed = parse_list("1, 2, x3", 8, ',', &error);
+	printf("\n\n>> Parsing \"1, 2, x3\", NULL: ");
+	PRINT_NULL(parsed);
+	printf(", error at byte %d", error);
+
+	// Freeze, thaw
+	frozen_list_t frozen = freeze(test);
+	printf("\n\n>> Frozen list_t with %d items in %d bytes, 10 is element: ",
+		frozen_size(frozen), (int)frozen_bytes(frozen));
+	PRINT_BOOL(frozen_is_element(10, frozen));
+	list_t thawed = thaw(frozen);
+	destroy_frozen(&frozen);
+	printf("\n\n>> list_t thawed again:\n");
+	formatted_print("%d", thawed);
+	destroy(&thawed);
+
+	// Persistent versions
+	persistent_list_t first = to_persistent(test);
+	persistent_list_t second = persistent_add(99, first);
+	persistent_list_t third = persistent_remove_at(second, 0);
+	printf("\n\n>> Persistent versions with %d, %d and %d items, last version:\n",
+		persistent_size(first), persistent_size(second), persistent_size(third));
+	list_t version = persistent_to_list(third);
+	formatted_print("%d", version);
+	destroy(&version);
+	printf("\n\n>> 99 is element of the first version: ");
+	PRINT_BOOL(persistent_is_element(99, first));
+	destroy_persistent(&first);
+	destroy_persistent(&second);
+	destroy_persistent(&third);
+
+	// Add range, insert range at
+	T range[] = { 100, 200, 300 };
+	add_range(range, 3, test);
+	insert_range_at(range, 3, test, 2);
+	expected += 6;
+	printf("\n\n>> Added 100, 200, 300 at the end and at index 2:\n");
+	PRINT_LIST;
+	PRINT_EXPECTED_SIZE;
+
 	// Is empty
 	printf("\n\n>> list_t empty: ");
 	PRINT_BOOL(is_empty(test));
@@ -289,6 +485,15 @@ void stack_test()
 	T temp;
 	peek(stack, &temp);
 	printf("\n\n>> Top element: %d", temp);
+	destroy(&stack);
+
+	// Array stack_t
+	stack = create_array_stack(4);
+	for (i = 0; i < 10; i++) push(i, stack);
+	pop(stack, &temp);
+	printf("\n\n>> Array stack_t, pushed 10 elements and popped %d:\n", temp);
+	formatted_print("%d", stack);
+	destroy(&stack);
 }
 
 #define PRINT_WITH_CHECK(check, item)                  \
@@ -337,6 +542,7 @@ void LINQ_test()
 		return !(item % 2) && item > 0;
 	}));
 	printf("\n\n>> Even numbers > 0: %d", result);
+	printf("\n>> Same count with DEFINE_COUNT: %d", count_even_positive(test));
 
 	// FirstIndexWhere
 	result = first_index_where(test, selector(item, 
@@ -357,6 +563,10 @@ void LINQ_test()
 	printf("\n\n>> list_t of numbers divisible for 3 inside the list_t:\n");
 	PRINT_TEMP;
 	DISPOSE_TEMP;
+	temp = where_multiple_of_3(test);
+	printf("\n\n>> Same list_t with DEFINE_WHERE:\n");
+	PRINT_TEMP;
+	DISPOSE_TEMP;
 
 	// TakeWhile
 	temp = take_while(test, selector(item, 
@@ -566,6 +776,56 @@ void LINQ_test()
 	DISPOSE_TEMP;
 }
 
+/* ---------------------------------------------------------------------
+*  InPlaceLINQTest
+*  ---------------------------------------------------------------------
+*  Description:
+*    Shows the in-place counterparts of the LINQ functions, that edit
+*    the nodes of the input list_t instead of creating a new one.
+*  NOTE:
+*    These functions work with SIDE EFFECT. */
+void in_place_LINQ_test()
+{
+	printf("\n\n======== IN-PLACE LINQ FUNCTIONS ========\n\n");
+
+	// Create random list
+	list_t test = create_random(15, -20, 30);
+	printf(">> Random list with 15 elements from -20 to 30:\n");
+	PRINT_LIST;
+
+	// WhereInPlace
+	int result = where_in_place(test, selector(item, { return item != 0; }));
+	printf("\n\n>> Keep the items != 0, removed %d items:\n", result);
+	PRINT_LIST;
+
+	// RemoveWhereInPlace
+	result = remove_where_in_place(test, selector(item, { return !(item % 5); }));
+	printf("\n\n>> Remove the items divisible for 5, removed %d items:\n", result);
+	PRINT_LIST;
+
+	// ReplaceWhereInPlace
+	result = replace_where_in_place(test, 0, selector(item, { return item < 0; }));
+	printf("\n\n>> Replace negative numbers with 0, replaced %d items:\n", result);
+	PRINT_LIST;
+
+	// DeriveInPlace
+	derive_in_place(test, deriver(item, { return item % 4; }));
+	printf("\n\n>> Derive each item mod 4:\n");
+	PRINT_LIST;
+
+	// ReverseInPlace
+	reverse_in_place(test);
+	printf("\n\n>> Reverse the list_t:\n");
+	PRINT_LIST;
+
+	// DistinctInPlace
+	result = distinct_in_place(test, equalityTester(item1, item2, { return item1 == item2; }));
+	printf("\n\n>> Distinct items, removed %d duplicates:\n", result);
+	PRINT_LIST;
+	PRINT_SIZE;
+	destroy(&test);
+}
+
 /* ---------------------------------------------------------------------
 *  IteratorTest
 *  ---------------------------------------------------------------------
@@ -618,6 +878,18 @@ void iterator_test()
 	printf("\n\n>> For each remaining item, print its value:\n");
 	for_each_remaining(iterator, block(item, { printf("%d ", item); }));
 
+	// NextChunk
+	printf("\n\n>> Restart and export the list_t in chunks of 4 items:");
+	restart(iterator);
+	T chunk[4];
+	int copied;
+	while ((copied = next_chunk(iterator, chunk, 4)) > 0)
+	{
+		printf("\n");
+		int i;
+		for (i = 0; i < copied; i++) printf("%d ", chunk[i]);
+	}
+
 	// Other tests
 	get_current(iterator, &value);
 	printf("\n\n>> Position and value: %d ---> %d", 
@@ -634,6 +906,53 @@ void iterator_test()
 	PRINT_BOOL(result);
 }
 
+/* ---------------------------------------------------------------------
+*  NamedListTest
+*  ---------------------------------------------------------------------
+*  Description:
+*    Shows a point_list, a list type with a struct item declared next to
+*    the int list_t: its functions have the point_list_ prefix and its
+*    lambda expressions receive a pointer to each point */
+void named_list_test()
+{
+	printf("\n\n======== NAMED LIST TYPES ========\n\n");
+	point_list_list_t points = point_list_create();
+	int i;
+	for (i = 0; i < 6; i++)
+	{
+		struct point item = { i, 10 - i * 3 };
+		point_list_add(item, points);
+	}
+	struct point target = { 2, 4 };
+	printf(">> Added %d points, index of (2, 4): %d", point_list_size(points), point_list_index_of(target, points));
+
+	// The lambda expressions use the item type of the named list, by pointer
+	point_list_list_t sorted = point_list_order_by(points, lambda(comparation, (const struct point* p1, const struct point* p2)
+	{
+		return p1->y > p2->y ? GREATER : p1->y < p2->y ? LOWER : EQUAL;
+	}));
+	printf("\n\n>> Sorted by y:\n");
+	point_list_for_each(sorted, lambda(void, (const struct point* p) { printf("(%d, %d) ", p->x, p->y); }));
+
+	// An int list_t can be used at the same time
+	list_t values = create();
+	point_list_for_each(sorted, lambda(void, (const struct point* p) { add(p->x * p->y, values); }));
+	printf("\n\n>> x * y for each sorted point:\n");
+	formatted_print("%d", values);
+	destroy(&values);
+	point_list_destroy(&sorted);
+
+	// Specialized functions for the named list
+	printf("\n\n>> Points above the x axis, with DEFINE_NAMED_COUNT: %d", count_above_axis(points));
+	point_list_list_t even = where_even_x(points);
+	sorted = sort_by_x_descending(even);
+	printf("\n>> Points with an even x, sorted by x descending with DEFINE_NAMED_WHERE and DEFINE_NAMED_SORT:\n");
+	point_list_for_each(sorted, lambda(void, (const struct point* p) { printf("(%d, %d) ", p->x, p->y); }));
+	point_list_destroy(&even);
+	point_list_destroy(&sorted);
+	point_list_destroy(&points);
+}
+
 // Returns the local clock time
 inline float get_time()
 {
@@ -645,7 +964,7 @@ void perform_benchmark(int len, comparation(*expression)(T, T))
 {
 	printf("\n\n>> Test with %d elements", len);
 	list_t test, sorted;
-	float totalIntro = 0, totalBubble = 0;
+	float totalIntro = 0, totalInlined = 0, totalBubble = 0;
 	int i;
 	for (i = 0; i < 10; i++)
 	{
@@ -659,6 +978,17 @@ void perform_benchmark(int len, comparation(*expression)(T, T))
 	}
 	printf("\n\n>> Total intro: %f", totalIntro);
 	for (i = 0; i < 10; i++)
+	{
+		test = create_random(len, -len, len);
+		float start, end;
+		start = get_time();
+		sorted = sort_ascending(test);
+		end = get_time();
+		destroy(&sorted);
+		totalInlined += end - start;
+	}
+	printf("\n>> Total inlined intro: %f", totalInlined);
+	for (i = 0; i < 10; i++)
 	{
 		test = create_random(len, -len, len);
 		float start, end;
@@ -703,6 +1033,12 @@ void sorting_benchmarks()
 		{
 			return n1 == n2;
 		}));
+		destroy(&compare);
+		compare = sort_ascending(test);
+		valid &= sequence_equals(sorted, compare, equalityTester(n1, n2,
+		{
+			return n1 == n2;
+		}));
 		destroy(&sorted);
 		destroy(&compare);
 		if (!valid) break;
@@ -714,6 +1050,514 @@ void sorting_benchmarks()
 	perform_benchmark(5000, expression);
 }
 
+// Number of threads and of push/pop pairs for each thread in the stack_t benchmark
+#define BENCHMARK_THREADS 4
+#define BENCHMARK_OPERATIONS 1000000
+
+// The stack_t shared by the benchmark threads, and the mutex used when it isn't lock-free
+stack_t benchmarkStack;
+pthread_mutex_t benchmarkMutex = PTHREAD_MUTEX_INITIALIZER;
+bool_t benchmarkLocked;
+
+// Pushes and pops items on the shared stack_t
+void* stack_worker(void* argument)
+{
+	(void)argument;
+	T item;
+	int i;
+	for (i = 0; i < BENCHMARK_OPERATIONS; i++)
+	{
+		if (benchmarkLocked) pthread_mutex_lock(&benchmarkMutex);
+		push(i, benchmarkStack);
+		if (benchmarkLocked) pthread_mutex_unlock(&benchmarkMutex);
+		if (benchmarkLocked) pthread_mutex_lock(&benchmarkMutex);
+		pop(benchmarkStack, &item);
+		if (benchmarkLocked) pthread_mutex_unlock(&benchmarkMutex);
+	}
+	return NULL;
+}
+
+// Returns the seconds needed by the benchmark threads to use the given stack_t
+float perform_stack_benchmark(stack_t stack, bool_t locked)
+{
+	pthread_t threads[BENCHMARK_THREADS];
+	struct timespec start, end;
+	benchmarkStack = stack;
+	benchmarkLocked = locked;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int i;
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_create(&threads[i], NULL, stack_worker, NULL);
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_join(threads[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	destroy(&benchmarkStack);
+	return (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+}
+
+// Returns the seconds needed by a single thread to push and pop items on
+// the given stack_t, keeping up to 1000 items in it
+float perform_single_stack_benchmark(stack_t stack)
+{
+	struct timespec start, end;
+	T item;
+	int i, j;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < BENCHMARK_OPERATIONS * BENCHMARK_THREADS / 1000; i++)
+	{
+		for (j = 0; j < 1000; j++) push(j, stack);
+		for (j = 0; j < 1000; j++) pop(stack, &item);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	destroy(&stack);
+	return (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+}
+
+// Number of items pushed by each thread in the lock-free stack_t stress test
+#define STRESS_ITEMS 200000
+
+// The number of times each item of the stress test was popped, and the
+// index of each thread, used to tag its items
+int* stressSeen;
+int stressIds[BENCHMARK_THREADS];
+
+// Pushes STRESS_ITEMS items tagged with the index of the thread on the
+// shared stack_t, and pops an item after every other push
+void* stress_worker(void* argument)
+{
+	int id = *(int*)argument, i;
+	T item;
+	for (i = 0; i < STRESS_ITEMS; i++)
+	{
+		push(id * STRESS_ITEMS + i, benchmarkStack);
+		if (i % 2 && pop(benchmarkStack, &item))
+		{
+			__atomic_add_fetch(&stressSeen[item], 1, __ATOMIC_RELAXED);
+		}
+	}
+	return NULL;
+}
+
+// Returns TRUE if every item pushed by the stress test threads on a
+// lock-free stack_t is popped exactly once, by them or after they stop
+bool_t perform_stack_stress_test()
+{
+	pthread_t threads[BENCHMARK_THREADS];
+	int total = BENCHMARK_THREADS * STRESS_ITEMS, i;
+	stressSeen = (int*)calloc(total, sizeof(int));
+	if (stressSeen == NULL) return FALSE;
+	benchmarkStack = create_lock_free_stack();
+	for (i = 0; i < BENCHMARK_THREADS; i++)
+	{
+		stressIds[i] = i;
+		pthread_create(&threads[i], NULL, stress_worker, &stressIds[i]);
+	}
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_join(threads[i], NULL);
+	T item;
+	bool_t valid = TRUE;
+	while (pop(benchmarkStack, &item))
+	{
+		if (item < 0 || item >= total) valid = FALSE;
+		else stressSeen[item]++;
+	}
+	for (i = 0; i < total; i++)
+	{
+		if (stressSeen[i] != 1) valid = FALSE;
+	}
+	free(stressSeen);
+	destroy(&benchmarkStack);
+	return valid;
+}
+
+/* ---------------------------------------------------------------------
+*  StackBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Checks that a lock-free stack_t never loses or duplicates an item,
+*    then compares a stack_t guarded by a mutex with a lock-free stack_t,
+*    used at the same time by different threads */
+void stack_benchmarks()
+{
+	printf("\n\n======== STACK BENCHMARKS ========\n\n");
+	printf(">> %d threads push %d tagged items each on a lock-free stack_t,\n", BENCHMARK_THREADS, STRESS_ITEMS);
+	printf(">> every item is popped exactly once: ");
+	PRINT_BOOL(perform_stack_stress_test());
+	printf("\n\n");
+	printf(">> %d threads, %d push/pop pairs each", BENCHMARK_THREADS, BENCHMARK_OPERATIONS);
+	printf("\n\n>> Mutex and stack_t: %f", perform_stack_benchmark(create(), TRUE));
+	printf("\n>> Lock-free stack_t: %f", perform_stack_benchmark(create_lock_free_stack(), FALSE));
+
+	// Single thread, nodes against an array
+	printf("\n\n>> 1 thread, %d push/pop pairs", BENCHMARK_OPERATIONS * BENCHMARK_THREADS);
+	printf("\n\n>> stack_t: %f", perform_single_stack_benchmark(create()));
+	printf("\n>> Array stack_t: %f", perform_single_stack_benchmark(create_array_stack(0)));
+}
+
+// The structures shared by the queue benchmark threads: a queue_t, or a
+// list_t guarded by a mutex when the queue_t is NULL
+queue_t benchmarkQueue;
+list_t benchmarkList;
+
+// Adds the items to the shared queue_t or list_t
+void* queue_producer(void* argument)
+{
+	(void)argument;
+	int i;
+	for (i = 0; i < BENCHMARK_OPERATIONS; i++)
+	{
+		if (benchmarkQueue != NULL)
+		{
+			while (!enqueue(i, benchmarkQueue)) sched_yield();
+			continue;
+		}
+		pthread_mutex_lock(&benchmarkMutex);
+		add(i, benchmarkList);
+		pthread_mutex_unlock(&benchmarkMutex);
+	}
+	return NULL;
+}
+
+// Removes the items from the shared queue_t or list_t, in order
+void* queue_consumer(void* argument)
+{
+	(void)argument;
+	T item;
+	int i;
+	for (i = 0; i < BENCHMARK_OPERATIONS; i++)
+	{
+		if (benchmarkQueue != NULL)
+		{
+			dequeue(benchmarkQueue, &item);
+			continue;
+		}
+		while (TRUE)
+		{
+			pthread_mutex_lock(&benchmarkMutex);
+			bool_t found = get_first(benchmarkList, &item) && remove_at(benchmarkList, 0);
+			pthread_mutex_unlock(&benchmarkMutex);
+			if (found) break;
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+// Returns the seconds needed by the producers and the consumers to
+// move their items through the given queue_t, or through a list_t
+float perform_queue_benchmark(queue_t queue)
+{
+	pthread_t threads[BENCHMARK_THREADS];
+	struct timespec start, end;
+	benchmarkQueue = queue;
+	benchmarkList = create();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int i;
+	for (i = 0; i < BENCHMARK_THREADS; i++)
+	{
+		pthread_create(&threads[i], NULL, i % 2 == 0 ? queue_producer : queue_consumer, NULL);
+	}
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_join(threads[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	destroy(&benchmarkList);
+	destroy_queue(&benchmarkQueue);
+	return (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+}
+
+/* ---------------------------------------------------------------------
+*  QueueBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Compares a queue_t with a list_t guarded by a mutex, used as a FIFO
+*    queue by some producer and consumer threads at the same time */
+void queue_benchmarks()
+{
+	printf("\n\n======== QUEUE BENCHMARKS ========\n\n");
+	printf(">> %d producers and %d consumers, %d items each",
+		BENCHMARK_THREADS / 2, BENCHMARK_THREADS / 2, BENCHMARK_OPERATIONS);
+	printf("\n\n>> Mutex and list_t: %f", perform_queue_benchmark(NULL));
+	printf("\n>> queue_t: %f", perform_queue_benchmark(create_queue(1024)));
+
+	// A single producer and a single consumer, with batches of items
+	queue_t queue = create_spsc_queue(1024);
+	T batch[64];
+	int i, moved = 0;
+	for (i = 0; i < 64; i++) batch[i] = i;
+	for (i = 0; i < 1000; i++)
+	{
+		enqueue_range(batch, 64, queue);
+		moved += dequeue_range(queue, batch, 64);
+	}
+	printf("\n\n>> Single producer and consumer queue_t, moved %d items in batches of 64", moved);
+	destroy_queue(&queue);
+}
+
+// The append_list_t filled by the append benchmark threads, or NULL when
+// they add their items to benchmarkList, guarded by a mutex
+append_list_t benchmarkAppendList;
+
+// Adds the items to the shared append_list_t or list_t
+void* append_worker(void* argument)
+{
+	(void)argument;
+	int i;
+	for (i = 0; i < BENCHMARK_OPERATIONS; i++)
+	{
+		if (benchmarkAppendList != NULL)
+		{
+			append(i, benchmarkAppendList);
+			continue;
+		}
+		pthread_mutex_lock(&benchmarkMutex);
+		add(i, benchmarkList);
+		pthread_mutex_unlock(&benchmarkMutex);
+	}
+	return NULL;
+}
+
+// Returns the seconds needed by the benchmark threads to fill the given
+// append_list_t and to seal it, or to fill a list_t
+float perform_append_benchmark(append_list_t list)
+{
+	pthread_t threads[BENCHMARK_THREADS];
+	struct timespec start, end;
+	benchmarkAppendList = list;
+	benchmarkList = create();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int i;
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_create(&threads[i], NULL, append_worker, NULL);
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_join(threads[i], NULL);
+	if (benchmarkAppendList != NULL)
+	{
+		destroy(&benchmarkList);
+		benchmarkList = seal(&benchmarkAppendList);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	destroy(&benchmarkList);
+	return (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+}
+
+/* ---------------------------------------------------------------------
+*  AppendBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Compares an append_list_t with a list_t guarded by a mutex, filled
+*    by some threads at the same time */
+void append_benchmarks()
+{
+	printf("\n\n======== APPEND BENCHMARKS ========\n\n");
+	printf(">> %d threads, %d items each", BENCHMARK_THREADS, BENCHMARK_OPERATIONS);
+	printf("\n\n>> Mutex and list_t: %f", perform_append_benchmark(NULL));
+	printf("\n>> append_list_t: %f", perform_append_benchmark(create_append_list()));
+}
+
+// Number of lookups performed by each reader in the rcu_list_t benchmark
+#define BENCHMARK_LOOKUPS 100000
+
+// The rcu_list_t read by the benchmark threads, or NULL when they read
+// benchmarkList, a concurrent list_t
+rcu_list_t benchmarkRCUList;
+
+// Looks for the items inside the shared rcu_list_t or list_t
+void* rcu_reader(void* argument)
+{
+	(void)argument;
+	int i;
+	for (i = 0; i < BENCHMARK_LOOKUPS; i++)
+	{
+		if (benchmarkRCUList != NULL)
+		{
+			is_element(i % 128, begin_rcu_read(benchmarkRCUList));
+			end_rcu_read(benchmarkRCUList);
+		}
+		else is_element(i % 128, benchmarkList);
+	}
+	return NULL;
+}
+
+// Adds an item to a version of the benchmark rcu_list_t
+bool_t rcu_writer(list_t list)
+{
+	return add(0, list);
+}
+
+// Returns the seconds needed by the benchmark threads to read the given
+// rcu_list_t or list_t, while the current thread edits it a few times
+float perform_rcu_benchmark(rcu_list_t rcu, list_t list)
+{
+	pthread_t threads[BENCHMARK_THREADS];
+	struct timespec start, end;
+	benchmarkRCUList = rcu;
+	benchmarkList = list;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int i;
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_create(&threads[i], NULL, rcu_reader, NULL);
+	for (i = 0; i < 10; i++)
+	{
+		if (rcu != NULL) update_rcu_list(rcu, rcu_writer);
+		else add(0, list);
+	}
+	for (i = 0; i < BENCHMARK_THREADS; i++) pthread_join(threads[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (rcu != NULL) destroy_rcu_list(&benchmarkRCUList);
+	if (list != NULL) destroy(&benchmarkList);
+	return (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+}
+
+/* ---------------------------------------------------------------------
+*  RCUBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Compares an rcu_list_t with a concurrent list_t, read by some threads
+*    while another one edits it */
+void rcu_benchmarks()
+{
+	printf("\n\n======== RCU BENCHMARKS ========\n\n");
+	printf(">> %d readers, %d lookups each in 256 items", BENCHMARK_THREADS, BENCHMARK_LOOKUPS);
+	list_t items = create(), shared = create_concurrent();
+	int i;
+	for (i = 0; i < 256; i++)
+	{
+		add(i, items);
+		add(i, shared);
+	}
+	printf("\n\n>> Concurrent list_t: %f", perform_rcu_benchmark(NULL, shared));
+	printf("\n>> rcu_list_t: %f", perform_rcu_benchmark(create_rcu_list(items), NULL));
+	destroy(&items);
+}
+
+// Number of steps and range of the items in the hash index benchmark
+#define BENCHMARK_INDEX_ITEMS 20000
+
+// Returns the seconds needed to use a list_t as a deduplicating cache: each
+// item is only added if the list_t doesn't contain it yet, and every other
+// step a random item is removed
+float perform_index_benchmark(bool_t indexed)
+{
+	list_t cache = create();
+	if (indexed) enable_hash_index(cache);
+	srand(0);
+	float start = get_time();
+	int i;
+	for (i = 0; i < BENCHMARK_INDEX_ITEMS; i++)
+	{
+		int item = rand() % BENCHMARK_INDEX_ITEMS;
+		if (!is_element(item, cache)) add(item, cache);
+		if (i % 2) remove_item(rand() % BENCHMARK_INDEX_ITEMS, cache);
+	}
+	float end = get_time();
+	destroy(&cache);
+	return end - start;
+}
+
+/* ---------------------------------------------------------------------
+*  IndexBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Compares the lookups and removals of a list_t with a hash index
+*    with the ones of a list_t that compares its items one by one */
+void index_benchmarks()
+{
+	printf("\n\n======== HASH INDEX BENCHMARKS ========\n\n");
+	printf(">> %d steps of a deduplicating cache", BENCHMARK_INDEX_ITEMS);
+	printf("\n\n>> Plain list_t: %f", perform_index_benchmark(FALSE));
+	printf("\n>> Indexed list_t: %f", perform_index_benchmark(TRUE));
+}
+
+#define BENCHMARK_BLOOM_ITEMS 20000
+
+// Returns the seconds needed to look for BENCHMARK_BLOOM_ITEMS items that
+// aren't inside a list_t with the same number of items, and copies the
+// counters of its bloom filter into stats, if it has one
+float perform_bloom_benchmark(bool_t filtered, bloom_stats_t* stats)
+{
+	list_t list = create();
+	int i;
+	for (i = 0; i < BENCHMARK_BLOOM_ITEMS; i++) add(i * 2, list);
+	if (filtered) enable_bloom_filter(list);
+	float start = get_time();
+	int found = 0;
+	for (i = 0; i < BENCHMARK_BLOOM_ITEMS; i++) found += is_element(i * 2 + 1, list);
+	float end = get_time();
+	get_bloom_stats(list, stats);
+	destroy(&list);
+	return found == 0 ? end - start : -1;
+}
+
+/* ---------------------------------------------------------------------
+*  BloomBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Compares the failed lookups of a list_t with a bloom filter
+*    with the ones of a list_t that compares its items one by one */
+void bloom_benchmarks()
+{
+	printf("\n\n======== BLOOM FILTER BENCHMARKS ========\n\n");
+	printf(">> %d missing items", BENCHMARK_BLOOM_ITEMS);
+	bloom_stats_t stats;
+	printf("\n\n>> Plain list_t: %f", perform_bloom_benchmark(FALSE, NULL));
+	printf("\n>> Filtered list_t: %f", perform_bloom_benchmark(TRUE, &stats));
+	printf("\n>> %lld checks, %lld rejected, %lld false positives",
+		stats.checks, stats.rejected, stats.false_positives);
+}
+
+#define BENCHMARK_GROUPING_ITEMS 1000000
+#define BENCHMARK_GROUPING_KEYS 100
+
+// Returns the seconds needed to split a list_t into BENCHMARK_GROUPING_KEYS
+// groups: with a where call for each key if threads is 0, with group_by if
+// it is 1 or with group_by_parallel otherwise
+float perform_grouping_benchmark(list_t list, int threads)
+{
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (threads == 0)
+	{
+		int key;
+		for (key = 0; key < BENCHMARK_GROUPING_KEYS; key++)
+		{
+			list_t group = where(list, lambda(bool_t, (T item) { return item % BENCHMARK_GROUPING_KEYS == key; }));
+			destroy(&group);
+		}
+	}
+	else
+	{
+		T(*key)(T) = deriver(item, { return item % BENCHMARK_GROUPING_KEYS; });
+		lookup_t lookup = threads == 1
+			? group_by(list, key, NULL, NULL)
+			: group_by_parallel(list, key, NULL, NULL, threads);
+		destroy_lookup(&lookup);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+}
+
+/* ---------------------------------------------------------------------
+*  GroupingBenchmarks
+*  ---------------------------------------------------------------------
+*  Description:
+*    Compares the grouping functions with a where call for each key */
+void grouping_benchmarks()
+{
+	printf("\n\n======== GROUPING BENCHMARKS ========\n\n");
+	printf(">> %d items, %d keys", BENCHMARK_GROUPING_ITEMS, BENCHMARK_GROUPING_KEYS);
+	list_t list = create_random(BENCHMARK_GROUPING_ITEMS, 0, 100000);
+	printf("\n\n>> where for each key: %f", perform_grouping_benchmark(list, 0));
+	printf("\n>> group_by: %f", perform_grouping_benchmark(list, 1));
+	printf("\n>> group_by_parallel (4 threads): %f", perform_grouping_benchmark(list, 4));
+	lookup_t counts = count_by(list, deriver(item, { return item % BENCHMARK_GROUPING_KEYS; }), NULL, NULL);
+	int total;
+	lookup_value(counts, 0, &total);
+	printf("\n>> count_by: %d items with key 0", total);
+	destroy_lookup(&counts);
+	destroy(&list);
+}
+
+// The functions of the point_list type
+#define LIST_NAME point_list
+#define LIST_TYPE struct point
+#define LIST_EQUALS(item1, item2) ((item1).x == (item2).x && (item1).y == (item2).y)
+#define LIST_NOT_NUMERIC
+#define LIST_BY_POINTER
+#include "Library\list_t.c"
+
 /* Copyright (C) 2015 Sergio Pedri
 
 * This library is free software; you can redistribute it and/or